@@ -25,6 +25,8 @@
 # include  "functor.h"
 # include  "compiler.h"
 # include  "ivl_assert.h"
+# include  <list>
+# include  <set>
 # include  <vector>
 
 
@@ -39,6 +41,16 @@ struct cprop_functor  : public functor_t {
 
       unsigned count;
 
+	// Nodes that are connected to a nexus that an optimization
+	// changed. These are scanned again after the first pass
+	// over the design, instead of scanning the whole design.
+      std::list<NetNode*> work_queue;
+      std::set<NetNode*> work_set;
+
+      void queue_nexus(Nexus*nex);
+      void delete_node(NetNode*obj);
+      void run_work_queue(Design*des);
+
       virtual void signal(Design*des, NetNet*obj);
       virtual void lpm_add_sub(Design*des, NetAddSub*obj);
       virtual void lpm_compare(Design*des, NetCompare*obj);
@@ -48,6 +60,42 @@ struct cprop_functor  : public functor_t {
       virtual void lpm_mux(Design*des, NetMux*obj);
 };
 
+void cprop_functor::queue_nexus(Nexus*nex)
+{
+      for (Link*cur = nex->first_nlink() ; cur ; cur = cur->next_nlink()) {
+	    NetNode*node = dynamic_cast<NetNode*>(cur->get_obj());
+	    if (node == 0)
+		  continue;
+	    if (work_set.insert(node).second)
+		  work_queue.push_back(node);
+      }
+}
+
+/*
+ * All the nodes that this functor deletes go through here, so that
+ * they are taken out of the work queue first.
+ */
+void cprop_functor::delete_node(NetNode*obj)
+{
+      work_set.erase(obj);
+      delete obj;
+}
+
+void cprop_functor::run_work_queue(Design*des)
+{
+      while (! work_queue.empty()) {
+	    NetNode*cur = work_queue.front();
+	    work_queue.pop_front();
+
+	      // Skip entries for nodes that were deleted after they
+	      // were queued.
+	    if (work_set.erase(cur) == 0)
+		  continue;
+
+	    cur->functor_node(des, this);
+      }
+}
+
 void cprop_functor::signal(Design*, NetNet*)
 {
 }
@@ -87,7 +135,7 @@ void cprop_functor::lpm_ff(Design*, NetFF*obj)
 	  && (! obj->pin_Aset().is_linked())) {
 	    obj->pin_Data().unlink();
 	    obj->pin_Q().unlink();
-	    delete obj;
+	    delete_node(obj);
       }
 }
 
@@ -145,9 +193,14 @@ void cprop_functor::lpm_mux(Design*des, NetMux*obj)
 	    connect(tmp->pin(1), obj->pin_Data(1));
       else
 	    connect(tmp->pin(1), obj->pin_Data(0));
-      delete obj;
+      delete_node(obj);
       des->add_node(tmp);
       count += 1;
+
+	// The nodes connected to the BUFZ see a different netlist
+	// now, so look at them again.
+      queue_nexus(tmp->pin(0).nexus());
+      queue_nexus(tmp->pin(1).nexus());
 }
 
 /*
@@ -249,17 +302,23 @@ void cprop_dc_functor::lpm_const(Design*, NetConst*obj)
 
 void cprop(Design*des)
 {
-	// Continually propagate constants until a scan finds nothing
-	// to do.
+	// Scan the whole design once. After that, only the nodes
+	// near an optimization can have something new to do, so keep
+	// scanning those until the work queue is empty.
       cprop_functor prop;
-      do {
-	    prop.count = 0;
-	    des->functor(&prop);
-	    if (verbose_flag) {
-		  cout << " ... Iteration detected "
-		       << prop.count << " optimizations." << endl << flush;
-	    }
-      } while (prop.count > 0);
+      prop.count = 0;
+      des->functor(&prop);
+      if (verbose_flag) {
+	    cout << " ... Design scan detected "
+		 << prop.count << " optimizations." << endl << flush;
+      }
+
+      unsigned scan_count = prop.count;
+      prop.run_work_queue(des);
+      if (verbose_flag) {
+	    cout << " ... Work queue detected "
+		 << (prop.count - scan_count) << " optimizations." << endl << flush;
+      }
 
       if (verbose_flag) {
 	    cout << " ... Look for dangling constants" << endl << flush;
@@ -3329,8 +3329,8 @@ NetProc* PEventStatement::elaborate_st(Design*des, NetScope*scope,
 	      /* NOTE: This event that I am adding to the wait may be
 		 a duplicate of another event somewhere else. However,
 		 I don't know that until all the modules are hooked
-		 up, so it is best to leave find_similar_event to
-		 after elaboration. */
+		 up, so it is best to leave merging similar events
+		 to after elaboration. */
       } else {
 	    delete ev;
       }
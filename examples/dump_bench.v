@@ -0,0 +1,40 @@
+/*
+ * Waveform dump throughput. The design has at least N signals, half
+ * of them 1 bit and half WIDTH bits wide. All of them change on every
+ * one of the CYCLES steps, and $dumpvars dumps the whole design, so
+ * each step writes about N value changes.
+ *
+ *    iverilog -o dump_bench -Ptop.N=100000 dump_bench.v
+ *    vvp -v dump_bench            (VCD, to dump.vcd)
+ *    vvp -v dump_bench -fst       (FST, to dump.fst)
+ *    vvp -v dump_bench -none      (no dump)
+ *
+ * The difference from the -none run time is the cost of the dumper.
+ */
+
+module top;
+
+   parameter N = 100000;
+   parameter WIDTH = 16;
+   parameter CYCLES = 100;
+
+   localparam BLOCKS = (N + 63) / 64;
+
+   reg [31:0] count = 0;
+
+   genvar i, k;
+   generate for (i = 0 ;  i < BLOCKS ;  i = i + 1) begin : blk
+      for (k = 0 ;  k < 32 ;  k = k + 1) begin : sig
+	 wire bit1 = count[0] ^ (k % 2) ^ (i % 2);
+	 wire [WIDTH-1:0] vec = count + k + i;
+      end
+   end endgenerate
+
+   initial begin
+      $dumpvars(0, top);
+      repeat (CYCLES) #1 count = count + 1;
+      $display("%0d signals, %0d cycles", BLOCKS*64, CYCLES);
+      $finish;
+   end
+
+endmodule
@@ -0,0 +1,35 @@
+/*
+ * Many always blocks waiting on one clock. Each of the N blocks has
+ * its own @(posedge clk) and counts the edges, and the clock runs for
+ * CYCLES cycles.
+ *
+ *    iverilog -o edge_fanout -Ptop.N=4096 edge_fanout.v
+ *    vvp -v edge_fanout
+ *
+ * Besides the run time, "vvp -v" prints the event counts. The thread
+ * event count shows how many scheduler events the clock edges cost.
+ */
+
+module top;
+
+   parameter N = 1024;
+   parameter CYCLES = 10000;
+
+   reg clk = 0;
+
+   genvar i;
+   generate for (i = 0 ;  i < N ;  i = i + 1) begin : blk
+      reg [31:0] count = 0;
+      always @(posedge clk) count <= count + 1;
+   end endgenerate
+
+   initial begin
+      repeat (2*CYCLES) #5 clk = ~clk;
+      if (blk[0].count !== CYCLES || blk[N-1].count !== CYCLES)
+	$display("FAILED -- count=%0d, expected %0d", blk[0].count, CYCLES);
+      else
+	$display("%0d always blocks, %0d cycles", N, CYCLES);
+      $finish;
+   end
+
+endmodule
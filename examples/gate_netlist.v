@@ -0,0 +1,39 @@
+/*
+ * A large flattened gate netlist, for timing the compiler. It is a
+ * chain of N and/nand gates, and every gate also reads the one enable
+ * net, so that net has a fan-out of N.
+ *
+ *    iverilog -v -tnull -Ptop.N=1000000 gate_netlist.v
+ *
+ * With -v the compiler prints the time of each step. Drop -tnull to
+ * also generate the vvp program and run it.
+ */
+
+module top;
+
+   parameter N = 100000;
+
+   reg in = 0, en = 1;
+   wire [N:0] chain;
+
+   assign chain[0] = in;
+
+   genvar i;
+   generate for (i = 0 ;  i < N ;  i = i + 1) begin : gate
+      if (i % 2 == 0) begin : g_and
+	 and g (chain[i+1], chain[i], en);
+      end else begin : g_nand
+	 nand g (chain[i+1], chain[i], en);
+      end
+   end endgenerate
+
+   initial begin
+      #1 in = 1;
+      #1 if (chain[N] !== (N % 2 ? 1'b0 : 1'b1))
+	$display("FAILED -- chain[N] = %b", chain[N]);
+      else
+	$display("%0d gates", N);
+      $finish;
+   end
+
+endmodule
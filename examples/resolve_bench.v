@@ -0,0 +1,58 @@
+/*
+ * Tri-state bus resolution. NDRV assigns share a WIDTH bit tri bus.
+ * Each step moves the enables to the next ACTIVE drivers, so every
+ * step resolves ACTIVE driving inputs and NDRV-ACTIVE floating ones.
+ * ACTIVE=1 is the ordinary bus. ACTIVE>1 makes the drivers fight,
+ * and KEEPER=1 adds a weak pull-high to the bus.
+ *
+ *    iverilog -o resolve_bench -Ptop.WIDTH=64 -Ptop.ACTIVE=1 resolve_bench.v
+ *    vvp -v resolve_bench
+ *
+ * resolve_check.v tests the same code for correctness.
+ */
+
+module top;
+
+   parameter WIDTH = 64;
+   parameter NDRV = 8;
+   parameter ACTIVE = 1;
+   parameter KEEPER = 0;
+   parameter STEPS = 200000;
+
+   reg [NDRV-1:0] en = 0, next;
+   reg [NDRV*WIDTH-1:0] data;
+   tri [WIDTH-1:0] bus;
+
+   genvar i;
+   generate if (KEEPER) begin : keep
+      assign (weak0, weak1) bus = {WIDTH{1'b1}};
+   end endgenerate
+
+   generate for (i = 0 ;  i < NDRV ;  i = i + 1) begin : drv
+      assign bus = en[i]? data[i*WIDTH +: WIDTH] : {WIDTH{1'bz}};
+   end endgenerate
+
+   integer idx, step;
+
+   initial begin
+      for (idx = 0 ;  idx < NDRV*WIDTH ;  idx = idx + 1)
+	data[idx] = $random;
+
+      for (step = 0 ;  step < STEPS ;  step = step + 1) begin
+	 next = 0;
+	 for (idx = 0 ;  idx < ACTIVE ;  idx = idx + 1)
+	   next[(step+idx) % NDRV] = 1;
+	 en = next;
+	 #1 ;
+      end
+
+      idx = (STEPS-1) % NDRV;
+      if (ACTIVE == 1 && bus !== data[idx*WIDTH +: WIDTH])
+	$display("FAILED -- bus=%h, expected %h", bus, data[idx*WIDTH +: WIDTH]);
+      else
+	$display("%0d drivers (%0d active), %0d bits, %0d steps",
+		 NDRV, ACTIVE, WIDTH, STEPS);
+      $finish;
+   end
+
+endmodule
@@ -0,0 +1,112 @@
+/*
+ * Random test of strength resolution on a vector net. Two strong
+ * assigns, one pull assign and one weak assign drive a WIDTH bit bus
+ * with random 0, 1, x and z bits. After each change the bus is
+ * compared with a model of the Verilog resolution rules, written as
+ * functions.
+ *
+ * vvp takes a word of bits at a time when the drivers agree or one of
+ * them floats, and goes bit by bit otherwise. To hit both cases, the
+ * test often copies one strong driver to the other, floats the weaker
+ * drivers, or floats the upper half of a driver. Widths that are not
+ * a multiple of the word size exercise the leftover bits:
+ *
+ *    for w in 1 7 8 9 16 31 64 65 100 ; do
+ *      iverilog -o resolve_check -Ptop.WIDTH=$w resolve_check.v
+ *      vvp resolve_check
+ *    done
+ *
+ * Each run prints PASSED or FAILED.
+ */
+
+module top;
+
+   parameter WIDTH = 37;
+   parameter TESTS = 20000;
+
+   reg [WIDTH-1:0] s0, s1, p0, w0;
+   tri [WIDTH-1:0] bus;
+
+   assign (strong0, strong1) bus = s0;
+   assign (strong0, strong1) bus = s1;
+   assign (pull0, pull1) bus = p0;
+   assign (weak0, weak1) bus = w0;
+
+     // Resolve the bits of one strength level. The result is z if
+     // none of the bits drive, or x if the driving bits do not agree.
+   function level;
+      input a, b;
+      begin
+	 level = a;
+	 if (b !== 1'bz) level = (a === 1'bz || a === b)? b : 1'bx;
+      end
+   endfunction
+
+   function [WIDTH-1:0] model;
+      input [WIDTH-1:0] s0, s1, p0, w0;
+      integer idx;
+      reg val;
+      begin
+	 for (idx = 0 ;  idx < WIDTH ;  idx = idx + 1) begin
+	    val = level(s0[idx], s1[idx]);
+	    if (val === 1'bz) val = level(p0[idx], 1'bz);
+	    if (val === 1'bz) val = level(w0[idx], 1'bz);
+	    model[idx] = val;
+	 end
+      end
+   endfunction
+
+   function [WIDTH-1:0] random_value;
+      input dummy;
+      integer idx, r;
+      begin
+	 for (idx = 0 ;  idx < WIDTH ;  idx = idx + 1) begin
+	    r = $random & 7;
+	    case (r)
+	      0, 1, 2: random_value[idx] = 1'bz;
+	      3, 4:    random_value[idx] = 1'b0;
+	      5, 6:    random_value[idx] = 1'b1;
+	      default: random_value[idx] = 1'bx;
+	    endcase
+	 end
+
+	 case ($random & 7)
+	   0: random_value = {WIDTH{1'bz}};
+	   1: random_value[WIDTH-1:WIDTH/2] = {WIDTH-WIDTH/2{1'bz}};
+	 endcase
+      end
+   endfunction
+
+   integer test, errors;
+
+   initial begin
+      errors = 0;
+      for (test = 0 ;  test < TESTS ;  test = test + 1) begin
+	 s0 = random_value(0);
+	 s1 = random_value(0);
+	 p0 = random_value(0);
+	 w0 = random_value(0);
+	 case ($random & 3)
+	   0: s1 = s0;
+	   1: begin
+	      p0 = {WIDTH{1'bz}};
+	      w0 = {WIDTH{1'bz}};
+	   end
+	 endcase
+
+	 #1 if (bus !== model(s0, s1, p0, w0)) begin
+	    if (errors < 10)
+	      $display("FAILED -- s0=%b s1=%b p0=%b w0=%b bus=%b, expected %b",
+		       s0, s1, p0, w0, bus, model(s0, s1, p0, w0));
+	    errors = errors + 1;
+	 end
+      end
+
+      if (errors == 0)
+	$display("PASSED -- %0d tests of %0d bits", TESTS, WIDTH);
+      else
+	$display("FAILED -- %0d of %0d tests", errors, TESTS);
+      $finish;
+   end
+
+endmodule
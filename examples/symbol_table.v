@@ -0,0 +1,37 @@
+/*
+ * vvp enters every label of the program into its symbol table while
+ * it compiles, and looks most of them up again to resolve references.
+ * This design makes N cells, and each cell is a scope with one net and
+ * one buf, so the generated file has about 3*N labels. N from 30000
+ * to 3000000 covers 10^5 to 10^7 labels. Generate the file once:
+ *
+ *    iverilog -o symbol_table -Ptop.N=1000000 symbol_table.v
+ *
+ * then run "vvp -v symbol_table". The time printed before the
+ * "Running ..." line is the startup cost. To count the labels:
+ *
+ *    grep -c '^[A-Za-z_]' symbol_table
+ */
+
+module top;
+
+   parameter N = 100000;
+
+   reg in = 0;
+
+   genvar i;
+   generate for (i = 0 ;  i < N ;  i = i + 1) begin : cell
+      wire out;
+      buf g (out, in);
+   end endgenerate
+
+   initial begin
+      #1 in = 1;
+      #1 if (cell[0].out !== 1'b1 || cell[N-1].out !== 1'b1)
+	$display("FAILED -- out = %b/%b", cell[0].out, cell[N-1].out);
+      else
+	$display("%0d cells", N);
+      $finish;
+   end
+
+endmodule
@@ -0,0 +1,58 @@
+/*
+ * Switch level mux trees. TREES binary trees of tranif0/tranif1
+ * pairs, LEVELS deep, share the same select lines, so they all end up
+ * in one tran island. The test drives only the leaves of tree 0 and
+ * steps the select lines STEPS times.
+ *
+ *    iverilog -o tran_mux_tree -Ptop.TREES=64 tran_mux_tree.v
+ *    vvp -v tran_mux_tree
+ */
+
+module top;
+
+   parameter LEVELS = 6;
+   parameter TREES = 16;
+   parameter STEPS = 20000;
+
+   localparam LEAVES = 1 << LEVELS;
+
+   reg [LEVELS-1:0] sel = 0;
+   reg [LEAVES-1:0] data = 0;
+
+   genvar t, l, k;
+   generate for (t = 0 ;  t < TREES ;  t = t + 1) begin : tree
+	// node[1] is the root and node[LEAVES+n] is leaf n. The
+	// children of node[i] are node[2*i] and node[2*i+1].
+      wire [2*LEAVES-1:1] node;
+
+      if (t == 0) begin : drv
+	 assign node[2*LEAVES-1:LEAVES] = data;
+      end
+
+      for (l = 0 ;  l < LEVELS ;  l = l + 1) begin : level
+	 for (k = (1 << l) ;  k < (2 << l) ;  k = k + 1) begin : sw
+	    tranif0 lo (node[k], node[2*k],   sel[LEVELS-1-l]);
+	    tranif1 hi (node[k], node[2*k+1], sel[LEVELS-1-l]);
+	 end
+      end
+   end endgenerate
+
+   integer idx, errors;
+   initial begin
+      errors = 0;
+      for (idx = 0 ;  idx < STEPS ;  idx = idx + 1) begin
+	 data = data + 1;
+	 if (idx % 16 == 0)
+	   sel = sel + 1;
+	 #1 if (tree[0].node[1] !== data[sel])
+	   errors = errors + 1;
+      end
+
+      if (errors)
+	$display("FAILED -- %0d mismatches", errors);
+      else
+	$display("%0d trees of %0d leaves, %0d steps", TREES, LEAVES, STEPS);
+      $finish;
+   end
+
+endmodule
@@ -0,0 +1,116 @@
+/*
+ * UDP evaluation rate, using a small cell library of UDPs: a 2:1 mux,
+ * a D latch and a D flip-flop with asynchronous reset. All N
+ * instances of each kind share their inputs, and the test changes one
+ * input at a time, so every change is N evaluations. At the end it
+ * prints the evaluation count for each kind. Divide that count by the
+ * run time that "vvp -v" prints to get evaluations per second.
+ *
+ *    iverilog -o udp_bench -Ptop.N=1000 udp_bench.v
+ *    vvp -v udp_bench
+ *
+ * KIND=1, 2 or 3 keeps only the mux, latch or flip-flop instances.
+ */
+
+primitive udp_mux2 (q, a, b, s);
+   output q;
+   input a, b, s;
+   table
+   // a b s : q
+      0 ? 0 : 0;
+      1 ? 0 : 1;
+      ? 0 1 : 0;
+      ? 1 1 : 1;
+      0 0 ? : 0;
+      1 1 ? : 1;
+   endtable
+endprimitive
+
+primitive udp_dlatch (q, d, en);
+   output q;
+   reg q;
+   input d, en;
+   table
+   // d en : q : q+
+      0 1  : ? : 0;
+      1 1  : ? : 1;
+      ? 0  : ? : -;
+      0 x  : 0 : 0;
+      1 x  : 1 : 1;
+   endtable
+endprimitive
+
+primitive udp_dffr (q, d, clk, rst);
+   output q;
+   reg q;
+   input d, clk, rst;
+   table
+   // d clk  rst : q : q+
+      ? ?    1   : ? : 0;
+      ? ?    *   : 0 : 0;
+      0 (01) 0   : ? : 0;
+      1 (01) 0   : ? : 1;
+      0 (0x) 0   : 0 : 0;
+      1 (0x) 0   : 1 : 1;
+      ? (?0) 0   : ? : -;
+      ? (1x) 0   : ? : -;
+      * ?    0   : ? : -;
+   endtable
+endprimitive
+
+module top;
+
+   parameter N = 1000;
+   parameter CYCLES = 10000;
+   parameter KIND = 0;
+
+   reg a = 0, b = 0, s = 0, d = 0, en = 0, clk = 0, rst = 1;
+
+   genvar i;
+   generate for (i = 0 ;  i < N ;  i = i + 1) begin : cell
+      wire q_mux, q_lat, q_ff;
+      if (KIND == 0 || KIND == 1) udp_mux2 mux (q_mux, a, b, s);
+      if (KIND == 0 || KIND == 2) udp_dlatch lat (q_lat, d, en);
+      if (KIND == 0 || KIND == 3) udp_dffr ff (q_ff, d, clk, rst);
+   end endgenerate
+
+     // Count the input changes that reach each kind of UDP. Every
+     // change of a UDP input is one evaluation of every instance.
+   integer mux_evals = 0, lat_evals = 0, ff_evals = 0;
+   integer cycle;
+
+   initial begin
+      #1 rst = 0;
+      ff_evals = ff_evals + 1;
+
+      for (cycle = 0 ;  cycle < CYCLES ;  cycle = cycle + 1) begin
+	 #1 a = ~a;
+	 mux_evals = mux_evals + 1;
+	 #1 b = ~b;
+	 mux_evals = mux_evals + 1;
+	 #1 s = ~s;
+	 mux_evals = mux_evals + 1;
+	 #1 d = ~d;
+	 lat_evals = lat_evals + 1;
+	 ff_evals = ff_evals + 1;
+	 #1 en = 1;
+	 lat_evals = lat_evals + 1;
+	 #1 en = 0;
+	 lat_evals = lat_evals + 1;
+	 #1 clk = 1;
+	 ff_evals = ff_evals + 1;
+	 #1 clk = 0;
+	 ff_evals = ff_evals + 1;
+      end
+
+      if (cell[0].q_ff !== d && (KIND == 0 || KIND == 3))
+	$display("FAILED -- q_ff=%b, expected %b", cell[0].q_ff, d);
+      else
+	$display("%0d mux, %0d latch and %0d flip-flop evaluations",
+		 (KIND == 0 || KIND == 1)? N*mux_evals : 0,
+		 (KIND == 0 || KIND == 2)? N*lat_evals : 0,
+		 (KIND == 0 || KIND == 3)? N*ff_evals : 0);
+      $finish;
+   end
+
+endmodule
@@ -20,6 +20,7 @@
 # include  "config.h"
 # include  "compiler.h"
 # include  "netlist.h"
+# include  <algorithm>
 
 /*
  * NOTE: The name_ is perm-allocated by the caller.
@@ -120,88 +121,102 @@ unsigned NetEvent::nexpr() const
 }
 
 /*
- * A "similar" event is one that has an identical non-nil set of
- * probes.
+ * A probe whose nexa are all watched by an earlier probe with the
+ * same edge can be deleted. To avoid comparing every pair of probes,
+ * the kept probes are indexed by the nexa they watch, and only the
+ * kept probes that share the first nexus of a probe are checked.
  */
-void NetEvent::find_similar_event(list<NetEvent*>&event_list)
+unsigned NetEvent::remove_duplicate_probes()
 {
-      if (probes_ == 0)
-	    return;
-
-      set<NetEvent*> candidate_events;
+      unsigned count = 0;
 
-	/* First, get a list of all the NetEvProbes that are connected
-	   to my first probe. Then use that to create a set of
-	   candidate events. These candidate events are a superset of
-	   the similar events, so I will be culling this list later. */
-      list<NetEvProbe*>first_probes;
-      probes_->find_similar_probes(first_probes);
+      vector<NetEvProbe*> keep;
+      vector< vector<const Nexus*> > keep_nexa;
+      map<const Nexus*, vector<unsigned> > nexus_index;
+      bool empty_seen[3] = { false, false, false };
 
-      for (list<NetEvProbe*>::iterator idx = first_probes.begin()
-		 ; idx != first_probes.end() ; ++ idx ) {
-
-	    candidate_events.insert( (*idx)->event() );
-      }
+      NetEvProbe*cur = probes_;
+      while (cur) {
+	    NetEvProbe*next = cur->enext_;
+
+	    vector<const Nexus*> nexa;
+	    bool linked = cur->pin_nexa(nexa);
+	    sort(nexa.begin(), nexa.end());
+	    nexa.erase(unique(nexa.begin(), nexa.end()), nexa.end());
+
+	    bool duplicate = false;
+	    if (cur->pin_count() == 0) {
+		  duplicate = empty_seen[cur->edge()];
+		  empty_seen[cur->edge()] = true;
+
+	    } else if (linked) {
+		  map<const Nexus*, vector<unsigned> >::const_iterator hit
+			= nexus_index.find(nexa[0]);
+		  if (hit != nexus_index.end()) {
+			const vector<unsigned>&cand = hit->second;
+			for (unsigned idx = 0 ; idx < cand.size() ; idx += 1) {
+			      if (keep[cand[idx]]->edge() != cur->edge())
+				    continue;
+			      const vector<const Nexus*>&tmp = keep_nexa[cand[idx]];
+			      if (includes(tmp.begin(), tmp.end(),
+					   nexa.begin(), nexa.end())) {
+				    duplicate = true;
+				    break;
+			      }
+			}
+		  }
+	    }
 
-      if (candidate_events.empty())
-	    return;
+	    if (duplicate) {
+		  delete cur;
+		  count += 1;
 
-	/* Now scan the remaining probes, in each case checking that
-	   the probe event is a candidate event. After each iteration,
-	   events that don't have a similar probe will be removed from
-	   the candidate_events set. If the candidate_events set
-	   becomes empty, then give up. */
-      unsigned probe_count = 1;
-      for (NetEvProbe*cur = probes_->enext_ ; cur;  cur = cur->enext_) {
-	    list<NetEvProbe*>similar_probes;
-	    cur->find_similar_probes(similar_probes);
-
-	    set<NetEvent*> candidate_tmp;
-	    for (list<NetEvProbe*>::iterator idx = similar_probes.begin()
-		       ; idx != similar_probes.end() ; ++ idx ) {
-
-		  NetEvent*tmp = (*idx)->event();
-		  if (candidate_events.find(tmp) != candidate_events.end())
-			candidate_tmp .insert(tmp);
+	    } else {
+		  unsigned idx = keep.size();
+		  keep.push_back(cur);
+		  keep_nexa.push_back(nexa);
+		  for (unsigned ndx = 0 ; ndx < nexa.size() ; ndx += 1)
+			nexus_index[nexa[ndx]].push_back(idx);
 	    }
 
-	      // None of the candidate events match this probe? Give up!
-	    if (candidate_tmp.empty())
-		  return;
-
-	    candidate_events = candidate_tmp;
-	    probe_count += 1;
+	    cur = next;
       }
 
-        /* Scan the surviving candidate events. We know that they all
-	   have probes that match the current event's probes. Check
-	   for remaining compatibility details and save the survivors
-	   in the event_list that the caller passed. */
-      for (set<NetEvent*>::iterator idx = candidate_events.begin()
-		 ; idx != candidate_events.end() ; ++ idx ) {
-
-	    NetEvent*tmp = *idx;
+      return count;
+}
 
-	      // This shouldn't be possible?
-	    if (tmp == this)
-		  continue;
+NetEvKey::NetEvKey(const NetEvent*ev)
+: valid(true), hash(0)
+{
+      for (const NetEvProbe*cur = ev->probes_ ; cur ; cur = cur->enext_) {
+	    probes.push_back(make_pair((int)cur->edge(), vector<const Nexus*>()));
+	    if (! cur->pin_nexa(probes.back().second))
+		  valid = false;
+      }
 
-              /* For automatic tasks, the VVP runtime holds state for events
-                 in the automatically allocated context. This means we can't
-                 merge similar events in different automatic tasks. */
-            if (scope()->is_auto() && (tmp->scope() != scope()))
-                  continue;
+      if (probes.empty())
+	    valid = false;
+      if (! valid)
+	    return;
 
-	    unsigned tcnt = 0;
-	    for (NetEvProbe*cur = tmp->probes_ ; cur ; cur = cur->enext_)
-		  tcnt += 1;
+      sort(probes.begin(), probes.end());
 
-	    if (tcnt == probe_count)
-		  event_list .push_back(tmp);
+      for (unsigned idx = 0 ; idx < probes.size() ; idx += 1) {
+	    hash = hash * 31 + probes[idx].first;
+	    const vector<const Nexus*>&nexa = probes[idx].second;
+	    for (unsigned ndx = 0 ; ndx < nexa.size() ; ndx += 1)
+		  hash = hash * 31 + (unsigned long)(size_t)nexa[ndx];
       }
-
 }
 
+bool NetEvKey::operator < (const NetEvKey&that) const
+{
+      if (valid != that.valid)
+	    return valid < that.valid;
+      if (hash != that.hash)
+	    return hash < that.hash;
+      return probes < that.probes;
+}
 
 void NetEvent::replace_event(NetEvent*that)
 {
@@ -304,38 +319,16 @@ const NetEvent* NetEvProbe::event() const
       return event_;
 }
 
-/*
- * A similar NetEvProbe is one that is connected to all the same nexa
- * that this probe is connected to, and also is the same edge
- * type. Don't count myself as a similar probe.
- */
-void NetEvProbe::find_similar_probes(list<NetEvProbe*>&plist)
+bool NetEvProbe::pin_nexa(vector<const Nexus*>&out) const
 {
-      Nexus*nex = pin(0).nexus();
-
-      for (Link*lcur = nex->first_nlink(); lcur; lcur = lcur->next_nlink()) {
-	    NetPins*obj = lcur->get_obj();
-	    if (obj->pin_count() != pin_count())
-		  continue;
-
-	    NetEvProbe*tmp = dynamic_cast<NetEvProbe*>(obj);
-	    if (tmp == 0)
-		  continue;
-
-	    if (tmp == this)
-		  continue;
-
-	    if (edge() != tmp->edge())
-		  continue;
-
-	    bool ok_flag = true;
-	    for (unsigned idx = 1 ;  ok_flag && idx < pin_count() ;  idx += 1)
-		  if (! pin(idx).is_linked(tmp->pin(idx)))
-			ok_flag = false;
-
-	    if (ok_flag == true)
-		  plist .push_back(tmp);
+      bool linked = true;
+      for (unsigned idx = 0 ;  idx < pin_count() ;  idx += 1) {
+	    const Nexus*nex = pin(idx).is_linked()? pin(idx).nexus() : 0;
+	    if (nex == 0)
+		  linked = false;
+	    out.push_back(nex);
       }
+      return linked;
 }
 
 NetEvWait::NetEvWait(NetProc*pr)
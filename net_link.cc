@@ -31,67 +31,95 @@
 
 void Nexus::connect(Link&r)
 {
-      Nexus*r_nexus = r.next_? r.find_nexus_() : 0;
+      Nexus*r_nexus = r.next_? r.nexus_ : 0;
       if (this == r_nexus)
 	    return;
 
       delete[] name_;
       name_ = 0;
 
-	// Special case: This nexus is empty. Simply copy all the
-	// links of the other nexus to this one, and delete the old
-	// nexus.
-      if (list_ == 0) {
-	    if (r.next_ == 0) {
+	// Special case: The Link is unconnected. Put it at the end of
+	// the current list and move the list_ pointer to suit.
+      if (r.next_ == 0) {
+	    r.nexus_ = this;
+	    nlinks_ += 1;
+
+	    if (list_ == 0) {
 		  list_ = &r;
 		  r.next_ = &r;
-		  r.nexus_ = this;
 		  driven_ = NO_GUESS;
-	    } else {
-		  driven_ = r_nexus->driven_;
-		  list_ = r_nexus->list_;
-		  list_->nexus_ = this;
-		  r_nexus->list_ = 0;
-		  delete r_nexus;
+		  return;
 	    }
-	    return;
-      }
 
-	// Special case: The Link is unconnected. Put it at the end of
-	// the current list and move the list_ pointer and nexus_ back
-	// pointer to suit.
-      if (r.next_ == 0) {
 	    if (r.get_dir() != Link::INPUT)
 		  driven_ = NO_GUESS;
 
-	    r.nexus_ = this;
 	    r.next_ = list_->next_;
 	    list_->next_ = &r;
-	    list_->nexus_ = 0;
 	    list_ = &r;
 	    return;
       }
 
-      if (r_nexus->driven_ != Vz)
-	    driven_ = NO_GUESS;
+      absorb_(r_nexus, false);
+}
 
-	// Splice the list of links from the "tmp" nexus to the end of
-	// this nexus. Adjust the nexus pointers as needed.
-      Link*save_first = list_->next_;
-      list_->next_ = r_nexus->list_->next_;
-      r_nexus->list_->next_ = save_first;
-      list_->nexus_ = 0;
-      list_ = r_nexus->list_;
-      list_->nexus_ = this;
+/*
+ * Move all the links of that nexus into this one, and delete that
+ * nexus. The links of that nexus go after the links of this one, or
+ * before them if prepend is true, so that the order of the links does
+ * not depend on which nexus is kept. Only the links of that nexus are
+ * visited, so connect(Link&,Link&) keeps the larger nexus.
+ */
+void Nexus::absorb_(Nexus*that, bool prepend)
+{
+      delete[] name_;
+      name_ = 0;
 
-      r_nexus->list_ = 0;
-      delete r_nexus;
+      Link*cur = that->list_;
+      do {
+	    cur->nexus_ = this;
+	    cur = cur->next_;
+      } while (cur != that->list_);
+
+	// Special case: This nexus is empty. Simply take all the
+	// links of the other nexus.
+      if (list_ == 0) {
+	    driven_ = that->driven_;
+	    list_ = that->list_;
+	    nlinks_ = that->nlinks_;
+
+      } else {
+	    const Nexus*first  = prepend? that : this;
+	    const Nexus*second = prepend? this : that;
+	    driven_ = second->driven_ != Vz? NO_GUESS : first->driven_;
+
+	      // Splice the two lists. The list_ pointer is the last
+	      // link, so it moves to the end of that list only when
+	      // that list goes at the end.
+	    Link*save_first = list_->next_;
+	    list_->next_ = that->list_->next_;
+	    that->list_->next_ = save_first;
+	    if (! prepend)
+		  list_ = that->list_;
+	    nlinks_ += that->nlinks_;
+      }
+
+      that->list_ = 0;
+      that->nlinks_ = 0;
+      delete that;
 }
 
 void connect(Link&l, Link&r)
 {
       assert(&l != &r);
-      if (l.nexus_ != 0) {
+      if (l.nexus_ != 0 && r.nexus_ != 0) {
+	    if (l.nexus_ == r.nexus_)
+		  return;
+	    if (r.nexus_->nlinks_ > l.nexus_->nlinks_)
+		  r.nexus_->absorb_(l.nexus_, true);
+	    else
+		  l.nexus_->absorb_(r.nexus_, false);
+      } else if (l.nexus_ != 0) {
 	    connect(l.nexus_, r);
       } else if (r.nexus_ != 0) {
 	    connect(r.nexus_, l);
@@ -120,11 +148,8 @@ Link::~Link()
 Nexus* Link::find_nexus_() const
 {
       assert(next_);
-      if (nexus_) return nexus_;
-      for (Link*cur = next_ ; cur != this ; cur = cur->next_) {
-	    if (cur->nexus_) return cur->nexus_;
-      }
-      return 0;
+      assert(nexus_);
+      return nexus_;
 }
 
 Nexus* Link::nexus()
@@ -226,14 +251,10 @@ bool Link::is_linked(const Link&that) const
 	    return false;
       if (that.next_ == 0)
 	    return false;
+      if (this == &that)
+	    return false;
 
-      const Link*cur = next_;
-      while (cur != this) {
-	    if (cur == &that) return true;
-	    cur = cur->next_;
-      }
-
-      return false;
+      return nexus_ == that.nexus_;
 }
 
 Nexus::Nexus(Link&that)
@@ -244,6 +265,7 @@ Nexus::Nexus(Link&that)
 
       if (that.next_ == 0) {
 	    list_ = &that;
+	    nlinks_ = 1;
 	    that.next_ = &that;
 	    that.nexus_ = this;
 	    driven_ = NO_GUESS;
@@ -251,11 +273,18 @@ Nexus::Nexus(Link&that)
       } else {
 	    Nexus*tmp = that.find_nexus_();
 	    list_ = tmp->list_;
-	    list_->nexus_ = this;
+	    nlinks_ = tmp->nlinks_;
 	    driven_ = tmp->driven_;
 	    name_ = tmp->name_;
 
+	    Link*cur = list_;
+	    do {
+		  cur->nexus_ = this;
+		  cur = cur->next_;
+	    } while (cur != list_);
+
 	    tmp->list_ = 0;
+	    tmp->nlinks_ = 0;
 	    tmp->name_ = 0;
 	    delete tmp;
       }
@@ -376,6 +405,7 @@ void Nexus::unlink(Link*that)
 	    assert(that->nexus_ == this);
 	    assert(list_ == that);
 	    list_ = 0;
+	    nlinks_ = 0;
 	    driven_ = NO_GUESS;
 	    that->nexus_ = 0;
 	    that->next_ = 0;
@@ -395,14 +425,12 @@ void Nexus::unlink(Link*that)
 	    prev = prev->next_;
 
       prev->next_ = that->next_;
+      nlinks_ -= 1;
 
 	// If "that" was the last item in the list, then change the
 	// list_ pointer to point to the new end of the list.
-      if (list_ == that) {
-	    assert(that->nexus_ == this);
+      if (list_ == that)
 	    list_ = prev;
-	    list_->nexus_ = this;
-      }
 
       that->nexus_ = 0;
       that->next_ = 0;
@@ -422,18 +450,12 @@ const Link* Nexus::first_nlink() const
 
 /*
  * The t_cookie can be set exactly once. This attaches an ivl_nexus_t
- * object to the Nexus, and causes the Link list to be marked up for
- * efficient use by the code generator. The change is to give all the
- * links a valid nexus_ pointer. This breaks most of the other
- * methods, but they are not used during code generation.
+ * object to the Nexus.
 */
 void Nexus::t_cookie(ivl_nexus_t val) const
 {
       assert(val && !t_cookie_);
       t_cookie_ = val;
-
-      for (Link*cur = list_->next_ ; cur->nexus_ == 0 ; cur = cur->next_)
-	    cur->nexus_ = const_cast<Nexus*> (this);
 }
 
 unsigned Nexus::vector_width() const
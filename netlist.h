@@ -166,8 +166,10 @@ class Link {
 
     private:
 	// The Nexus uses these to maintain its list of Link
-	// objects. If this link is not connected to anything,
-	// then these pointers are both nil.
+	// objects. Every connected link points to its nexus, so
+	// finding the nexus of a link does not need to scan the
+	// list. If this link is not connected to anything, then
+	// these pointers are both nil.
       Link *next_;
       Nexus*nexus_;
 
@@ -312,15 +314,13 @@ class NetBranch  : public NetPins, public IslandBranch {
  * The links in a nexus are grouped into a circularly linked list,
  * with the nexus pointing to the last Link. Each link in turn points
  * to the next link in the nexus, with the last link pointing back to
- * the first. The last link also has a non-nil nexus_ pointer back to
- * this nexus.
+ * the first. Every link also has a nexus_ pointer back to this
+ * nexus. When two nexus objects are joined, the links of the smaller
+ * one are moved to the larger one.
  *
  * The t_cookie() is an ivl_nexus_t that the code generator uses to
  * store data in the nexus. When a Nexus is created, this cookie is
- * set to nil. The code generator may set the cookie once. This locks
- * the nexus, and rewrites the Link list to be optimal for the code
- * generator. In the process, *all* of the other methods are no longer
- * functional.
+ * set to nil. The code generator may set the cookie once.
  */
 class Nexus {
 
@@ -379,7 +379,9 @@ class Nexus {
 
     private:
       Link*list_;
+      unsigned nlinks_;
       void unlink(Link*);
+      void absorb_(Nexus*that, bool prepend);
 
       mutable char* name_; /* Cache the calculated name for the Nexus. */
       mutable ivl_nexus_t t_cookie_;
@@ -2679,6 +2681,7 @@ class NetEvent : public LineInfo {
       friend class NetEvTrig;
       friend class NetEvWait;
       friend class NetEEvent;
+      friend struct NetEvKey;
 
     public:
 	// The name of the event is the basename, and should not
@@ -2704,13 +2707,14 @@ class NetEvent : public LineInfo {
 
       void nex_output(NexusSet&);
 
-	// Locate the first event that matches my behavior and
-	// monitors the same signals.
-      void find_similar_event(list<NetEvent*>&);
+	// Delete the probes that watch a subset of the nexa of an
+	// earlier probe with the same edge. Return the number of
+	// probes deleted.
+      unsigned remove_duplicate_probes();
 
 	// This method replaces pointers to me with pointers to
 	// that. It is typically used to replace similar events
-	// located by the find_similar_event method.
+	// located through their NetEvKey.
       void replace_event(NetEvent*that);
 
     private:
@@ -2819,6 +2823,7 @@ ostream& operator << (ostream&out, const NetEvWait&obj);
 class NetEvProbe  : public NetNode {
 
       friend class NetEvent;
+      friend struct NetEvKey;
 
     public:
       enum edge_t { ANYEDGE, POSEDGE, NEGEDGE };
@@ -2831,7 +2836,9 @@ class NetEvProbe  : public NetNode {
       NetEvent* event();
       const NetEvent* event() const;
 
-      void find_similar_probes(list<NetEvProbe*>&);
+	// Get the nexa that the pins of this probe are connected
+	// to, in pin order. Return false if any pin is unconnected.
+      bool pin_nexa(vector<const Nexus*>&out) const;
 
       virtual bool emit_node(struct target_t*) const;
       virtual void dump_node(ostream&, unsigned ind) const;
@@ -2843,6 +2850,26 @@ class NetEvProbe  : public NetNode {
       NetEvProbe*enext_;
 };
 
+/*
+ * A NetEvKey is a canonical description of the probes of an event:
+ * the edge and connected nexa of each probe, with the probes in a
+ * fixed order. Events with equal keys are similar, in that they watch
+ * the same signals for the same edges, so the references to one can
+ * be replaced with references to the other. The keys are ordered by
+ * a hash first, so that a map of keys rarely has to compare the
+ * probe lists. An event with no probes, or with a probe that is not
+ * fully connected, has an invalid key and is similar to nothing.
+ */
+struct NetEvKey {
+      explicit NetEvKey(const NetEvent*ev);
+
+      bool valid;
+      unsigned long hash;
+      vector< pair<int,vector<const Nexus*> > > probes;
+
+      bool operator < (const NetEvKey&that) const;
+};
+
 /*
  * The force statement causes the r-val net to be forced onto the
  * l-val net when it is executed. The code generator is expected to
@@ -4102,18 +4129,18 @@ inline __ScopePathManip scope_path(const NetScope*scope)
 extern ostream& operator << (ostream&o, __ScopePathManip);
 
 /*
- * If this link has a nexus_ pointer, then it is the last Link in the
- * list. next_nlink() returns 0 for the last Link.
+ * The nexus points to the last Link in the list. next_nlink()
+ * returns 0 for the last Link.
  */
 inline Link* Link::next_nlink()
 {
-      if (nexus_) return 0;
+      if (nexus_ == 0 || nexus_->list_ == this) return 0;
       else return next_;
 }
 
 inline const Link* Link::next_nlink() const
 {
-      if (nexus_) return 0;
+      if (nexus_ == 0 || nexus_->list_ == this) return 0;
       else return next_;
 }
 
@@ -28,22 +28,62 @@
 # include  "functor.h"
 # include  "netlist.h"
 # include  "compiler.h"
+# include  <climits>
+# include  <map>
+# include  <vector>
 
 class nodangle_f  : public functor_t {
     public:
       void event(Design*des, NetEvent*ev);
       void signal(Design*des, NetNet*sig);
 
-      unsigned iteration;
+      void merge_events(unsigned pass);
+
       unsigned stotal, etotal;
-      bool scontinue, econtinue;
-      bool scomplete, ecomplete;
+
+	// The events that survive the scan of the design. The later
+	// passes work from this list instead of scanning the whole
+	// design again. Entries for deleted events are set to nil.
+      vector<NetEvent*> events;
+      bool auto_pending;
+
+	// The events that are similar to each other are grouped
+	// together by their NetEvKey. The similar_ list holds the
+	// index in the events list of each member of each group, and
+	// each event has the index of the start of its group.
+      void group_similar_events();
+      vector<unsigned> similar_;
+      vector<unsigned> group_start_;
 };
 
-void nodangle_f::event(Design*, NetEvent*ev)
+void nodangle_f::group_similar_events()
 {
-      if (ecomplete) return;
+      map<NetEvKey, vector<unsigned> > groups;
+      group_start_.assign(events.size(), UINT_MAX);
+
+      for (unsigned idx = 0 ;  idx < events.size() ;  idx += 1) {
+	    NetEvKey key (events[idx]);
+	    if (key.valid)
+		  groups[key].push_back(idx);
+      }
+
+      for (map<NetEvKey, vector<unsigned> >::iterator cur = groups.begin()
+		 ; cur != groups.end() ; ++ cur ) {
+	    const vector<unsigned>&members = cur->second;
+	    if (members.size() < 2)
+		  continue;
 
+	    unsigned start = similar_.size();
+	    for (unsigned idx = 0 ;  idx < members.size() ;  idx += 1) {
+		  similar_.push_back(members[idx]);
+		  group_start_[members[idx]] = start;
+	    }
+	    similar_.push_back(UINT_MAX);
+      }
+}
+
+void nodangle_f::event(Design*, NetEvent*ev)
+{
 	/* If there are no references to this event, then go right
 	   ahead and delete it. There is no use looking further at
 	   it. */
@@ -53,79 +93,74 @@ void nodangle_f::event(Design*, NetEvent*ev)
 	    return;
       }
 
-      if (iteration == 0) {
-              /* Try to remove duplicate probes from the event. This
-                 is done as a separate initial pass to ensure similar
-                 events are detected as soon as possible in subsequent
-                 iterations. */
-            for (unsigned idx = 0 ;  idx < ev->nprobe() ;  idx += 1) {
-                  unsigned jdx = idx + 1;
-                  while (jdx < ev->nprobe()) {
-                        NetEvProbe*ip = ev->probe(idx);
-                        NetEvProbe*jp = ev->probe(jdx);
-
-                        if (ip->edge() != jp->edge()) {
-                              jdx += 1;
-                              continue;
-                        }
-
-                        bool fully_connected = true;
-                        for (unsigned jpin = 0; jpin < jp->pin_count(); jpin += 1) {
-                              unsigned ipin = 0;
-                              bool connected_flag = false;
-                              for (ipin = 0 ; ipin < ip->pin_count(); ipin += 1)
-                                    if (connected(ip->pin(ipin), jp->pin(jpin))) {
-                                          connected_flag = true;
-                                          break;
-                                    }
-
-                              if (!connected_flag) {
-                                    fully_connected = false;
-                                    break;
-                              }
-                        }
-
-                        if (fully_connected) {
-                              delete jp;
-                        } else {
-                              jdx += 1;
-                        }
-                  }
-            }
-            econtinue = true;
-      } else {
-              /* Postpone examining events in an automatic scope until the
-                 third (optional) pass. This will mean similar events are
-                 biased towards being stored in static scopes. */
-            if (ev->scope()->is_auto()) {
-                  if (iteration == 1) {
-                        econtinue = true;
-                        return;
-                  }
-            } else {
-                  if (iteration == 2) {
-                        return;
-                  }
-            }
-
-              /* Try to find all the events that are similar to me, and
-                 replace their references with references to me. */
-            list<NetEvent*> match;
-            ev->find_similar_event(match);
-            for (list<NetEvent*>::iterator idx = match.begin()
-                       ; idx != match.end() ; ++ idx ) {
-
-                  NetEvent*tmp = *idx;
-                  assert(tmp != ev);
-                  tmp ->replace_event(ev);
-            }
+	/* Remove duplicate probes from the event. This is done as a
+	   separate initial pass to ensure similar events are detected
+	   as soon as possible in subsequent passes. */
+      ev->remove_duplicate_probes();
+
+      events.push_back(ev);
+}
+
+/*
+ * Merge similar events. Pass 1 looks at the events in static scopes
+ * and pass 2 at the events in automatic scopes. Postponing the
+ * automatic events until the second pass means similar events are
+ * biased towards being stored in static scopes.
+ */
+void nodangle_f::merge_events(unsigned pass)
+{
+      auto_pending = false;
+
+      for (unsigned idx = 0 ;  idx < events.size() ;  idx += 1) {
+	    NetEvent*ev = events[idx];
+	    if (ev == 0)
+		  continue;
+
+	      /* Events that lost all their references to a similar
+		 event are deleted here. */
+	    if ((ev->nwait() + ev->ntrig() + ev->nexpr()) == 0) {
+		  delete ev;
+		  events[idx] = 0;
+		  etotal += 1;
+		  continue;
+	    }
+
+	    if (ev->scope()->is_auto()) {
+		  if (pass == 1) {
+			auto_pending = true;
+			continue;
+		  }
+	    } else {
+		  if (pass == 2)
+			continue;
+	    }
+
+	      /* Replace the references to all the events that are
+		 similar to me with references to me. */
+	    if (group_start_[idx] == UINT_MAX)
+		  continue;
+
+	    for (unsigned sdx = group_start_[idx]
+		       ; similar_[sdx] != UINT_MAX ; sdx += 1) {
+
+		  NetEvent*tmp = events[similar_[sdx]];
+		  if (tmp == 0 || tmp == ev)
+			continue;
+
+		    /* For automatic tasks, the VVP runtime holds state
+		       for events in the automatically allocated
+		       context. This means we can't merge similar events
+		       in different automatic tasks. */
+		  if (ev->scope()->is_auto() && (tmp->scope() != ev->scope()))
+			continue;
+
+		  tmp ->replace_event(ev);
+	    }
       }
 }
 
 void nodangle_f::signal(Design*, NetNet*sig)
 {
-      if (scomplete) return;
-
 	/* Cannot delete signals referenced in an expression
 	   or an l-value. */
       if (sig->get_refs() > 0)
@@ -195,33 +230,39 @@ void nodangle_f::signal(Design*, NetNet*sig)
 void nodangle(Design*des)
 {
       nodangle_f fun;
-      fun.iteration = 0;
       fun.stotal = 0;
       fun.etotal = 0;
-      fun.scomplete = false;
-      fun.ecomplete = false;
-      do {
-	    if (verbose_flag) {
-		  cout << " ... scan for dangling signal and event nodes. "
-		       << "(scomplete=" << (fun.scomplete? "T" : "F")
-		       << ", ecomplete=" << (fun.ecomplete? "T" : "F")
-		       << ")" << endl << flush;
-	    }
+      fun.auto_pending = false;
+
+	/* Scan the design once. This deletes the dangling signals and
+	   events, and collects the remaining events. Deleting a
+	   signal never leaves another signal dangling, so the signals
+	   are done after this scan. */
+      if (verbose_flag) {
+	    cout << " ... scan for dangling signal and event nodes." << endl << flush;
+      }
+      des->functor(&fun);
+      if (verbose_flag) {
+	    cout << " ... deleted " << fun.stotal << " dangling signals"
+		 << " and " << fun.etotal << " events." << endl << flush;
+      }
 
-            fun.scontinue = false;
-            fun.econtinue = false;
-	    des->functor(&fun);
-	    fun.iteration += 1;
-            fun.scomplete = !fun.scontinue;
-            fun.ecomplete = !fun.econtinue;
+	/* Merge similar events. Only the collected events take part
+	   in these passes. */
+      fun.group_similar_events();
+      for (unsigned pass = 1 ;  pass <= 2 ;  pass += 1) {
+	    if (pass == 2 && !fun.auto_pending)
+		  break;
+	    if (fun.events.empty())
+		  break;
 
+	    fun.merge_events(pass);
 	    if (verbose_flag) {
-		  cout << " ... " << fun.iteration << " iterations"
-		       << " deleted " << fun.stotal << " dangling signals"
-		       << " and " << fun.etotal << " events." << endl << flush;
+		  cout << " ... event pass " << pass << " of "
+		       << fun.events.size() << " events deleted "
+		       << fun.etotal << " events." << endl << flush;
 	    }
-
-      } while (fun.scontinue || fun.econtinue);
+      }
 
       if (verbose_flag) {
 	    cout << " ... done" << endl << flush;
@@ -24,6 +24,7 @@
 
 #include "fstapi.h"
 #include "fastlz.h"
+#include <pthread.h>
 
 
 /* this define is to force writer backward compatibility with old readers */
@@ -454,6 +455,10 @@ unsigned active : 1;
 };
 
 
+struct fstWriterBlock;
+
+enum fstWriterThreadsState { FST_THREADS_UNSTARTED = 0, FST_THREADS_RUNNING, FST_THREADS_NONE };
+
 struct fstWriterContext
 {
 FILE *handle;
@@ -500,6 +505,21 @@ uint32_t num_blackouts;
 
 uint64_t dump_size_limit;
 
+int compress_level;	/* libz level for the value change records */
+int compress_workers;	/* threads that compress the value change records, 0 for none */
+
+/* the writer thread and its helpers, see fstWriterWriteBlock() */
+enum fstWriterThreadsState threads_state;
+pthread_t writer_thread;
+pthread_t *pack_threads;
+int num_pack_threads;
+pthread_mutex_t thread_mutex;
+pthread_cond_t thread_cond;
+struct fstWriterBlock *write_blk;	/* block in flight, owned by the writer thread */
+struct fstWriterBlock *pack_blk;	/* block whose records are being compressed */
+int pack_next, pack_done;
+int thread_quit;
+
 unsigned compress_hier : 1;
 unsigned repack_on_close : 1;
 unsigned skip_writing_section_hdr : 1;
@@ -512,6 +532,11 @@ unsigned char already_in_close; /* in case control-c handlers interrupt */
 };
 
 
+static void fstWriterWaitBlock(struct fstWriterContext *xc);
+static void fstWriterStopThreads(struct fstWriterContext *xc);
+static void fstWriterFlushContextPrivate(struct fstWriterContext *xc);
+
+
 static uint32_t fstWriterUint32WithVarint32(struct fstWriterContext *xc, uint32_t *u, uint32_t v, const void *dbuf, uint32_t siz)
 {
 unsigned char *buf = xc->vchg_mem + xc->vchg_siz;
@@ -641,7 +666,10 @@ fflush(xc->handle);
  */
 static void fstWriterCreateMmaps(struct fstWriterContext *xc)
 {
-off_t curpos = ftello(xc->handle);
+off_t curpos;
+
+fstWriterWaitBlock(xc);
+curpos = ftello(xc->handle);
 
 fflush(xc->hier_handle);
 
@@ -673,6 +701,8 @@ if(!xc->curval_mem)
 
 static void fstDestroyMmaps(struct fstWriterContext *xc, int is_closing)
 {
+fstWriterWaitBlock(xc);
+
 fstMunmap(xc->valpos_mem, xc->maxhandle * 4 * sizeof(uint32_t));
 xc->valpos_mem = NULL;
 
@@ -710,6 +740,8 @@ void *fstWriterCreate(const char *nam, int use_compressed_hier)
 struct fstWriterContext *xc = calloc(1, sizeof(struct fstWriterContext));
 
 xc->compress_hier = use_compressed_hier;
+xc->compress_level = 4;
+xc->compress_workers = 1;
 
 if((!nam)||(!(xc->handle=unlink_fopen(nam, "w+b"))))
         {
@@ -767,6 +799,7 @@ if(xc && !xc->already_in_close && !xc->already_in_flush)
 	off_t fixup_offs, tlen, hlen;
 
 	xc->already_in_close = 1; /* never need to zero this out as it is freed at bottom */
+	fstWriterStopThreads(xc); /* finishes the block in flight, the rest is written here */
 
 	if(xc->section_header_only && xc->section_header_truncpos && (xc->vchg_siz <= 1) && (!xc->is_initial_time))
 		{
@@ -1027,46 +1060,45 @@ if(xc && !xc->already_in_close && !xc->already_in_flush)
 /*
  * generation and writing out of value change data sections
  */
-static void fstWriterEmitSectionHeader(void *ctx)
+static void fstWriterEmitSectionHeader(struct fstWriterContext *xc, uint64_t begin, uint64_t end,
+	uint32_t maxvalpos, fstHandle maxhandle)
 {
-struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
-
 if(xc)
 	{
 	unsigned long destlen;
 	unsigned char *dmem;
         int rc;
 
-	destlen = xc->maxvalpos;
+	destlen = maxvalpos;
 	dmem = malloc(destlen);
-        rc = compress2(dmem, &destlen, xc->curval_mem, xc->maxvalpos, 9);
+        rc = compress2(dmem, &destlen, xc->curval_mem, maxvalpos, 9);
 
 	fputc(FST_BL_SKIP, xc->handle);			/* temporarily tag the section, use FST_BL_VCDATA on finalize */
 	xc->section_start = ftello(xc->handle);
 	xc->section_header_only = 1;			/* indicates truncate might be needed */
 	fstWriterUint64(xc->handle, 0); 		/* placeholder = section length */
-	fstWriterUint64(xc->handle, xc->is_initial_time ? xc->firsttime : xc->curtime); 	/* begin time of section */
-	fstWriterUint64(xc->handle, xc->curtime); 	/* end time of section (placeholder) */
+	fstWriterUint64(xc->handle, begin); 	/* begin time of section */
+	fstWriterUint64(xc->handle, end); 		/* end time of section (placeholder) */
 	fstWriterUint64(xc->handle, 0);			/* placeholder = amount of buffer memory required in reader for full vc traversal */
-	fstWriterVarint(xc->handle, xc->maxvalpos);	/* maxvalpos = length of uncompressed data */
+	fstWriterVarint(xc->handle, maxvalpos);	/* maxvalpos = length of uncompressed data */
 
-	if((rc == Z_OK) && (destlen < xc->maxvalpos))
+	if((rc == Z_OK) && (destlen < maxvalpos))
 		{
 		fstWriterVarint(xc->handle, destlen);	/* length of compressed data */
 		}
 		else
 		{
-		fstWriterVarint(xc->handle, xc->maxvalpos); /* length of (unable to be) compressed data */
+		fstWriterVarint(xc->handle, maxvalpos); /* length of (unable to be) compressed data */
 		}
-	fstWriterVarint(xc->handle, xc->maxhandle);	/* max handle associated with this data (in case of dynamic facility adds) */
+	fstWriterVarint(xc->handle, maxhandle);	/* max handle associated with this data (in case of dynamic facility adds) */
 
-	if((rc == Z_OK) && (destlen < xc->maxvalpos))
+	if((rc == Z_OK) && (destlen < maxvalpos))
 		{
 		fstFwrite(dmem, destlen, 1, xc->handle);
 		}
 		else /* comparison between compressed / decompressed len tells if compressed */
 		{
-		fstFwrite(xc->curval_mem, xc->maxvalpos, 1, xc->handle);
+		fstFwrite(xc->curval_mem, maxvalpos, 1, xc->handle);
 		}
 
 	free(dmem);
@@ -1074,31 +1106,156 @@ if(xc)
 }
 
 
-void fstWriterFlushContext(void *ctx)
+/*
+ * a flush is split in two.  the simulator thread builds the value
+ * change records of the block, and takes a copy of the time changes,
+ * so that it can go on filling the buffers of the next block.  the
+ * rest (compressing the records, writing them in handle order, the
+ * index, the time table, the trailer and the next section header) is
+ * done by fstWriterWriteBlock().  that normally runs on a writer thread
+ * that belongs to the context, so the simulation continues while the
+ * block is written out.  only one block is in flight: a flush waits for
+ * the previous block first.  the records of a block are compressed
+ * independently, so the writer thread shares them with compress_workers-1
+ * helper threads.  the file is the same for any number of workers.
+ */
+struct fstWriterPackJob
+{
+unsigned char *src;
+unsigned char *dst;
+uint32_t len;
+uint32_t clen;		/* zero if the record is stored uncompressed */
+uint32_t pos;		/* position for the index, set when written */
+int handle;
+};
+
+struct fstWriterBlock
+{
+unsigned char *scratchpad;
+unsigned char *packmem;
+struct fstWriterPackJob *jobs;
+int njobs;
+fstHandle maxhandle;
+uint32_t maxvalpos;
+off_t unc_memreq;
+unsigned char *tchn_mem;	/* copy of the time changes of the block */
+off_t tchn_len;
+uint32_t tchn_cnt;
+uint64_t curtime;
+uint64_t dump_size_limit;
+int compress_level;
+unsigned fastpack : 1;
+unsigned skip_writing_section_hdr : 1;
+};
+
+
+static void fstWriterPackOne(const struct fstWriterBlock *blk, struct fstWriterPackJob *job)
+{
+if(job->len <= 32) return;
+
+if(!blk->fastpack)
+	{
+	unsigned long destlen = job->len;
+	int rc = compress2(job->dst, &destlen, job->src, job->len, blk->compress_level);
+	if(rc == Z_OK)
+		{
+		job->clen = destlen;
+		}
+	}
+	else
+	{
+	int rc = fastlz_compress(job->src, job->len, job->dst);
+	if(rc < job->len)
+		{
+		job->clen = rc;
+		}
+	}
+}
+
+
+/* take jobs of the current pack until there are none left, called with the mutex held */
+static void fstWriterPackTake(struct fstWriterContext *xc)
+{
+while(xc->pack_blk && (xc->pack_next < xc->pack_blk->njobs))
+	{
+	struct fstWriterBlock *blk = xc->pack_blk;
+	int idx = xc->pack_next++;
+
+	pthread_mutex_unlock(&xc->thread_mutex);
+	fstWriterPackOne(blk, &blk->jobs[idx]);
+	pthread_mutex_lock(&xc->thread_mutex);
+
+	if(++xc->pack_done == blk->njobs)
+		{
+		pthread_cond_broadcast(&xc->thread_cond);
+		}
+	}
+}
+
+
+static void *fstWriterPackThread(void *arg)
+{
+struct fstWriterContext *xc = (struct fstWriterContext *)arg;
+
+pthread_mutex_lock(&xc->thread_mutex);
+for(;;)
+	{
+	fstWriterPackTake(xc);
+	if(xc->thread_quit) break;
+	pthread_cond_wait(&xc->thread_cond, &xc->thread_mutex);
+	}
+pthread_mutex_unlock(&xc->thread_mutex);
+
+return(NULL);
+}
+
+
+static void fstWriterPackJobs(struct fstWriterContext *xc, struct fstWriterBlock *blk)
+{
+int i;
+
+if(xc->num_pack_threads == 0)
+	{
+	for(i=0;i<blk->njobs;i++)
+		{
+		fstWriterPackOne(blk, &blk->jobs[i]);
+		}
+	return;
+	}
+
+pthread_mutex_lock(&xc->thread_mutex);
+xc->pack_blk = blk;
+xc->pack_next = 0;
+xc->pack_done = 0;
+pthread_cond_broadcast(&xc->thread_cond);
+
+fstWriterPackTake(xc);
+while(xc->pack_done < blk->njobs)
+	{
+	pthread_cond_wait(&xc->thread_cond, &xc->thread_mutex);
+	}
+xc->pack_blk = NULL;
+pthread_mutex_unlock(&xc->thread_mutex);
+}
+
+
+static void fstWriterWriteBlock(struct fstWriterContext *xc, struct fstWriterBlock *blk)
 {
 #ifdef FST_DEBUG
 int cnt = 0;
 #endif
 int i;
-unsigned char *vchg_mem;
 FILE *f;
 off_t fpos, indxpos, endpos;
 uint32_t prevpos;
 int zerocnt;
-unsigned char *scratchpad;
-unsigned char *scratchpnt;
-unsigned char *tmem;
-off_t tlen;
-off_t unc_memreq = 0; /* for reader */
-unsigned char *packmem;
-unsigned int packmemlen;
-uint32_t *vm4ip;
-struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
+fstHandle nexthandle;
+struct fstWriterPackJob *jobs = blk->jobs;
 
 #ifndef FST_DYNAMIC_ALIAS_DISABLE
 Pvoid_t PJHSArray = (Pvoid_t) NULL;
 #ifndef _WAVE_HAVE_JUDY
-uint32_t hashmask =  xc->maxhandle;
+uint32_t hashmask =  blk->maxhandle;
 hashmask |= hashmask >> 1;
 hashmask |= hashmask >> 2;
 hashmask |= hashmask >> 4;
@@ -1107,21 +1264,319 @@ hashmask |= hashmask >> 16;
 #endif
 #endif
 
+f = xc->handle;
+fstWriterVarint(f, blk->maxhandle);	/* emit current number of handles */
+fputc(blk->fastpack ? 'F' : 'Z', f);
+fpos = 1;
+
+fstWriterPackJobs(xc, blk);
+
+/* results are written in handle order so the file is the same for any worker count */
+for(i=0;i<blk->njobs;i++)
+	{
+	unsigned char *wmem;
+	uint32_t wlen, ulen;
+
+	jobs[i].pos = fpos;
+
+	if(jobs[i].clen)
+		{
+		wmem = jobs[i].dst;
+		wlen = jobs[i].clen;
+		ulen = jobs[i].len;
+		}
+		else
+		{
+		wmem = jobs[i].src;
+		wlen = jobs[i].len;
+		ulen = 0;
+		}
+
+#ifndef FST_DYNAMIC_ALIAS_DISABLE
+	{
+	PPvoid_t pv = JudyHSIns(&PJHSArray, wmem, wlen, NULL);
+	if(*pv)
+		{
+		uint32_t pvi = (long)(*pv);
+		jobs[i].pos = -pvi;
+		}
+		else
+		{
+		*pv = (void *)(long)(jobs[i].handle+1);
+#endif
+		fpos += fstWriterVarint(f, ulen);
+		fpos += wlen;
+		fstFwrite(wmem, wlen, 1, f);
+#ifndef FST_DYNAMIC_ALIAS_DISABLE
+		}
+	}
+#endif
+
+#ifdef FST_DEBUG
+	cnt++;
+#endif
+	}
+
+#ifndef FST_DYNAMIC_ALIAS_DISABLE
+JudyHSFreeArray(&PJHSArray, NULL);
+#endif
+
+free(blk->packmem); blk->packmem = NULL;
+free(blk->scratchpad); blk->scratchpad = NULL;
+
+indxpos = ftello(f);
+
+/* the jobs are in handle order, and the handles without one are counted as runs of zeros */
+prevpos = 0; zerocnt = 0;
+nexthandle = 0;
+for(i=0;i<blk->njobs;i++)
+	{
+	zerocnt += jobs[i].handle - nexthandle;
+	nexthandle = jobs[i].handle + 1;
+
+	if(zerocnt)
+		{
+		fpos += fstWriterVarint(f, (zerocnt << 1));
+		zerocnt = 0;
+		}
+
+	if(jobs[i].pos & 0x80000000)
+		{
+		fpos += fstWriterVarint(f, 0); /* signal */
+		fpos += fstWriterVarint(f, (-(int32_t)jobs[i].pos));
+		}
+		else
+		{
+		fpos += fstWriterVarint(f, ((jobs[i].pos - prevpos) << 1) | 1);
+		prevpos = jobs[i].pos;
+		}
+	}
+zerocnt += blk->maxhandle - nexthandle;
+if(zerocnt)
+	{
+	fpos += fstWriterVarint(f, (zerocnt << 1));
+	}
+#ifdef FST_DEBUG
+printf("value chains: %d\n", cnt);
+#endif
+
+free(blk->jobs); blk->jobs = jobs = NULL;
+
+endpos = ftello(xc->handle);
+fstWriterUint64(xc->handle, endpos-indxpos);		/* write delta index position at very end of block */
+
+/*emit time changes for block */
+if(blk->tchn_mem)
+	{
+	off_t tlen = blk->tchn_len;
+	unsigned long destlen = tlen;
+	unsigned char *dmem = malloc(destlen);
+        int rc = compress2(dmem, &destlen, blk->tchn_mem, tlen, 9);
+
+	if((rc == Z_OK) && (destlen < tlen))
+		{
+		fstFwrite(dmem, destlen, 1, xc->handle);
+		}
+		else /* comparison between compressed / decompressed len tells if compressed */
+		{
+		fstFwrite(blk->tchn_mem, tlen, 1, xc->handle);
+		destlen = tlen;
+		}
+	free(dmem);
+	free(blk->tchn_mem); blk->tchn_mem = NULL;
+	fstWriterUint64(xc->handle, tlen);		/* uncompressed */
+	fstWriterUint64(xc->handle, destlen);		/* compressed */
+	fstWriterUint64(xc->handle, blk->tchn_cnt); 	/* number of time items */
+	}
+
+/* write block trailer */
+endpos = ftello(xc->handle);
+fseeko(xc->handle, xc->section_start, SEEK_SET);
+fstWriterUint64(xc->handle, endpos - xc->section_start); 	/* write block length */
+fseeko(xc->handle, 8, SEEK_CUR);				/* skip begin time */
+fstWriterUint64(xc->handle, blk->curtime); 			/* write end time for section */
+fstWriterUint64(xc->handle, blk->unc_memreq);			/* amount of buffer memory required in reader for full traversal */
+fflush(xc->handle);
+
+fseeko(xc->handle, xc->section_start-1, SEEK_SET);		/* write out FST_BL_VCDATA over FST_BL_SKIP */
+
+#ifndef FST_DYNAMIC_ALIAS_DISABLE
+fputc(FST_BL_VCDATA_DYN_ALIAS, xc->handle);
+#else
+fputc(FST_BL_VCDATA, xc->handle);
+#endif
+
+fflush(xc->handle);
+
+fseeko(xc->handle, endpos, SEEK_SET);				/* seek to end of file */
+
+xc->section_header_truncpos = endpos;				/* cache in case of need to truncate */
+if(blk->dump_size_limit)
+	{
+	if(endpos >= blk->dump_size_limit)
+		{
+		/* the flush waits for a block when there is a limit, so these are seen in time */
+		xc->skip_writing_section_hdr = 1;
+		xc->size_limit_locked = 1;
+		xc->is_initial_time = 1; /* to trick emit value and emit time change */
+		blk->skip_writing_section_hdr = 1;
+#ifdef FST_DEBUG
+		printf("<< dump file size limit reached, stopping dumping >>\n");
+#endif
+		}
+	}
+
+if(!blk->skip_writing_section_hdr)
+	{
+	fstWriterEmitSectionHeader(xc, blk->curtime, blk->curtime, blk->maxvalpos, blk->maxhandle); /* emit next section header */
+	}
+fflush(xc->handle);
+
+free(blk);
+}
+
+
+static void *fstWriterWriterThread(void *arg)
+{
+struct fstWriterContext *xc = (struct fstWriterContext *)arg;
+
+pthread_mutex_lock(&xc->thread_mutex);
+for(;;)
+	{
+	struct fstWriterBlock *blk = xc->write_blk;
+
+	if(blk)
+		{
+		pthread_mutex_unlock(&xc->thread_mutex);
+		fstWriterWriteBlock(xc, blk);
+		pthread_mutex_lock(&xc->thread_mutex);
+
+		xc->write_blk = NULL;
+		pthread_cond_broadcast(&xc->thread_cond);
+		continue;
+		}
+
+	if(xc->thread_quit) break;
+	pthread_cond_wait(&xc->thread_cond, &xc->thread_mutex);
+	}
+pthread_mutex_unlock(&xc->thread_mutex);
+
+return(NULL);
+}
+
+
+/*
+ * the threads are started by the first flush and run until the context
+ * is closed.  if they cannot be started the blocks are written by the
+ * flushing thread, as they are when compress_workers is zero.
+ */
+static void fstWriterStartThreads(struct fstWriterContext *xc)
+{
+int i;
+
+xc->threads_state = FST_THREADS_NONE;
+if(xc->compress_workers < 1) return;
+
+pthread_mutex_init(&xc->thread_mutex, NULL);
+pthread_cond_init(&xc->thread_cond, NULL);
+if(pthread_create(&xc->writer_thread, NULL, fstWriterWriterThread, xc))
+	{
+	pthread_cond_destroy(&xc->thread_cond);
+	pthread_mutex_destroy(&xc->thread_mutex);
+	return;
+	}
+xc->threads_state = FST_THREADS_RUNNING;
+
+xc->pack_threads = malloc((xc->compress_workers - 1) * sizeof(pthread_t) + 1);
+for(i=0;i<xc->compress_workers-1;i++)
+	{
+	if(pthread_create(&xc->pack_threads[i], NULL, fstWriterPackThread, xc))
+		{
+		break;
+		}
+	}
+xc->num_pack_threads = i;
+}
+
+
+/* wait until the writer thread has finished the block in flight, if any */
+static void fstWriterWaitBlock(struct fstWriterContext *xc)
+{
+if(xc->threads_state != FST_THREADS_RUNNING) return;
+
+pthread_mutex_lock(&xc->thread_mutex);
+while(xc->write_blk)
+	{
+	pthread_cond_wait(&xc->thread_cond, &xc->thread_mutex);
+	}
+pthread_mutex_unlock(&xc->thread_mutex);
+}
+
+
+static void fstWriterStopThreads(struct fstWriterContext *xc)
+{
+int i;
+
+if(xc->threads_state != FST_THREADS_RUNNING)
+	{
+	xc->threads_state = FST_THREADS_NONE;
+	return;
+	}
+
+fstWriterWaitBlock(xc);
+
+pthread_mutex_lock(&xc->thread_mutex);
+xc->thread_quit = 1;
+pthread_cond_broadcast(&xc->thread_cond);
+pthread_mutex_unlock(&xc->thread_mutex);
+
+pthread_join(xc->writer_thread, NULL);
+for(i=0;i<xc->num_pack_threads;i++)
+	{
+	pthread_join(xc->pack_threads[i], NULL);
+	}
+free(xc->pack_threads); xc->pack_threads = NULL;
+xc->num_pack_threads = 0;
+
+pthread_cond_destroy(&xc->thread_cond);
+pthread_mutex_destroy(&xc->thread_mutex);
+xc->threads_state = FST_THREADS_NONE;
+}
+
+
+static void fstWriterFlushContextPrivate(struct fstWriterContext *xc)
+{
+int i;
+unsigned char *vchg_mem;
+unsigned char *scratchpad;
+unsigned char *scratchpnt;
+off_t tlen;
+off_t unc_memreq = 0; /* for reader */
+unsigned char *scratchtop;
+unsigned char *packpnt;
+unsigned int packmemlen;
+uint32_t *vm4ip;
+struct fstWriterPackJob *jobs;
+int njobs;
+struct fstWriterBlock *blk;
+
 if((!xc)||(xc->vchg_siz <= 1)||(xc->already_in_flush)) return;
 xc->already_in_flush = 1; /* should really do this with a semaphore */
 
+if(xc->threads_state == FST_THREADS_UNSTARTED)
+	{
+	fstWriterStartThreads(xc);
+	}
+fstWriterWaitBlock(xc);	/* the writer thread owns the file and curval_mem until then */
+
 xc->section_header_only = 0;
 scratchpad = malloc(xc->vchg_siz);
 
 vchg_mem = xc->vchg_mem;
 
-f = xc->handle;
-fstWriterVarint(f, xc->maxhandle);	/* emit current number of handles */
-fputc(xc->fastpack ? 'F' : 'Z', f);
-fpos = 1;
-
-packmemlen = 1024;			/* maintain a running "longest" allocation to */
-packmem = malloc(packmemlen);		/* prevent continual malloc...free every loop iter */
+jobs = malloc(xc->maxhandle * sizeof(struct fstWriterPackJob) + 1);
+njobs = 0;
+scratchtop = scratchpad + xc->vchg_siz;	/* the records are built backwards, one below the other */
 
 for(i=0;i<xc->maxhandle;i++)
 	{
@@ -1133,9 +1588,7 @@ for(i=0;i<xc->maxhandle;i++)
 		uint32_t next_offs;
 		int wrlen;
 
-		vm4ip[2] = fpos;
-
-		scratchpnt = scratchpad + xc->vchg_siz;		/* build this buffer backwards */
+		scratchpnt = scratchtop;		/* build this buffer backwards */
 		if(vm4ip[1] <= 1)
 			{
 			if(vm4ip[1] == 1)
@@ -1260,284 +1713,114 @@ for(i=0;i<xc->maxhandle;i++)
 				}
 			}
 
-		wrlen = scratchpad + xc->vchg_siz - scratchpnt;
+		wrlen = scratchtop - scratchpnt;
 		unc_memreq += wrlen;
-		if(wrlen > 32)
-			{
-			unsigned long destlen = wrlen;
-			unsigned char *dmem;
-		        int rc;
-
-			if(!xc->fastpack)
-				{
-				if(wrlen <= packmemlen)
-					{
-					dmem = packmem;
-					}
-					else
-					{
-					free(packmem);
-					dmem = packmem = malloc(packmemlen = wrlen);
-					}
-
-		        	rc = compress2(dmem, &destlen, scratchpnt, wrlen, 4);
-				if(rc == Z_OK)
-					{
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-					PPvoid_t pv = JudyHSIns(&PJHSArray, dmem, destlen, NULL);
-					if(*pv)
-						{
-						uint32_t pvi = (long)(*pv);
-						vm4ip[2] = -pvi;
-						}
-						else
-						{
-						*pv = (void *)(long)(i+1);
-#endif
-						fpos += fstWriterVarint(f, wrlen);
-						fpos += destlen;
-						fstFwrite(dmem, destlen, 1, f);
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-						}
-#endif
-					}
-					else
-					{
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-					PPvoid_t pv = JudyHSIns(&PJHSArray, scratchpnt, wrlen, NULL);
-					if(*pv)
-						{
-						uint32_t pvi = (long)(*pv);
-						vm4ip[2] = -pvi;
-						}
-						else
-						{
-						*pv = (void *)(long)(i+1);
-#endif
-						fpos += fstWriterVarint(f, 0);
-						fpos += wrlen;
-						fstFwrite(scratchpnt, wrlen, 1, f);
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-						}
-#endif
-					}
-				}
-				else
-				{
-				if(((wrlen * 2) + 2) <= packmemlen)
-					{
-					dmem = packmem;
-					}
-					else
-					{
-					free(packmem);
-					dmem = packmem = malloc(packmemlen = (wrlen * 2) + 2);
-					}
 
-				rc = fastlz_compress(scratchpnt, wrlen, dmem);
-				if(rc < destlen)
-        				{
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-					PPvoid_t pv = JudyHSIns(&PJHSArray, dmem, rc, NULL);
-					if(*pv)
-						{
-						uint32_t pvi = (long)(*pv);
-						vm4ip[2] = -pvi;
-						}
-						else
-						{
-						*pv = (void *)(long)(i+1);
-#endif
-						fpos += fstWriterVarint(f, wrlen);
-						fpos += rc;
-						fstFwrite(dmem, rc, 1, f);
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-						}
-#endif
-        				}
-        				else
-        				{
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-					PPvoid_t pv = JudyHSIns(&PJHSArray, scratchpnt, wrlen, NULL);
-					if(*pv)
-						{
-						uint32_t pvi = (long)(*pv);
-						vm4ip[2] = -pvi;
-						}
-						else
-						{
-						*pv = (void *)(long)(i+1);
-#endif
-						fpos += fstWriterVarint(f, 0);
-						fpos += wrlen;
-						fstFwrite(scratchpnt, wrlen, 1, f);
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-						}
-#endif
-        				}
-				}
-			}
-			else
-			{
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-			PPvoid_t pv = JudyHSIns(&PJHSArray, scratchpnt, wrlen, NULL);
-			if(*pv)
-				{
-				uint32_t pvi = (long)(*pv);
-				vm4ip[2] = -pvi;
-				}
-				else
-				{
-				*pv = (void *)(long)(i+1);
-#endif
-				fpos += fstWriterVarint(f, 0);
-				fpos += wrlen;
-				fstFwrite(scratchpnt, wrlen, 1, f);
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-				}
-#endif
-			}
+		jobs[njobs].handle = i;
+		jobs[njobs].src = scratchpnt;
+		jobs[njobs].len = wrlen;
+		jobs[njobs].dst = NULL;
+		jobs[njobs].clen = 0;
+		jobs[njobs].pos = 0;
+		njobs++;
 
-		vm4ip[3] = 0;
-#ifdef FST_DEBUG
-		cnt++;
-#endif
+		scratchtop = scratchpnt;
+		vm4ip[2] = 0;
+		vm4ip[3] = 0; /* clear out tchn idx */
 		}
 	}
 
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-JudyHSFreeArray(&PJHSArray, NULL);
-#endif
-
-free(packmem); packmem = NULL; packmemlen = 0;
-
-prevpos = 0; zerocnt = 0;
-free(scratchpad); scratchpad = NULL;
-
-indxpos = ftello(f);
-xc->secnum++;
-
-for(i=0;i<xc->maxhandle;i++)
+packmemlen = 0;
+for(i=0;i<njobs;i++)
 	{
-	vm4ip = &(xc->valpos_mem[4*i]);
-
-	if(vm4ip[2])
+	if(jobs[i].len > 32)
 		{
-		if(zerocnt)
-			{
-			fpos += fstWriterVarint(f, (zerocnt << 1));
-			zerocnt = 0;
-			}
-
-		if(vm4ip[2] & 0x80000000)
-			{
-			fpos += fstWriterVarint(f, 0); /* signal */
-			fpos += fstWriterVarint(f, (-(int32_t)vm4ip[2]));
-			}
-			else
-			{
-			fpos += fstWriterVarint(f, ((vm4ip[2] - prevpos) << 1) | 1);
-			prevpos = vm4ip[2];
-			}
-		vm4ip[2] = 0;
-		vm4ip[3] = 0; /* clear out tchn idx */
-		}
-		else
-		{
-		zerocnt++;		
+		packmemlen += xc->fastpack ? ((jobs[i].len * 2) + 2) : jobs[i].len;
 		}
 	}
-if(zerocnt)
+
+blk = calloc(1, sizeof(struct fstWriterBlock));
+blk->scratchpad = scratchpad;
+blk->packmem = malloc(packmemlen ? packmemlen : 1);
+blk->jobs = jobs;
+blk->njobs = njobs;
+blk->maxhandle = xc->maxhandle;
+blk->maxvalpos = xc->maxvalpos;
+blk->unc_memreq = unc_memreq;
+blk->curtime = xc->curtime;
+blk->dump_size_limit = xc->dump_size_limit;
+blk->compress_level = xc->compress_level;
+blk->fastpack = xc->fastpack;
+blk->skip_writing_section_hdr = xc->skip_writing_section_hdr;
+
+packpnt = blk->packmem;
+for(i=0;i<njobs;i++)
 	{
-	fpos += fstWriterVarint(f, (zerocnt << 1));
+	if(jobs[i].len > 32)
+		{
+		jobs[i].dst = packpnt;
+		packpnt += xc->fastpack ? ((jobs[i].len * 2) + 2) : jobs[i].len;
+		}
 	}
-#ifdef FST_DEBUG
-printf("value chains: %d\n", cnt);
-#endif
 
 xc->vchg_mem[0] = '!';
 xc->vchg_siz = 1;
+xc->secnum++;
 
-endpos = ftello(xc->handle);
-fstWriterUint64(xc->handle, endpos-indxpos);		/* write delta index position at very end of block */
-
-/*emit time changes for block */
+/* copy the time changes of the block, and start the table of the next one */
 fflush(xc->tchn_handle);
 tlen = ftello(xc->tchn_handle);
 fseeko(xc->tchn_handle, 0, SEEK_SET);
 
-tmem = fstMmap(NULL, tlen, PROT_READ|PROT_WRITE, MAP_SHARED, fileno(xc->tchn_handle), 0);
-if(tmem)
+blk->tchn_mem = malloc(tlen ? tlen : 1);
+blk->tchn_len = tlen;
+blk->tchn_cnt = xc->tchn_cnt;
+if(tlen && (fread(blk->tchn_mem, tlen, 1, xc->tchn_handle) != 1))
 	{
-	unsigned long destlen = tlen;
-	unsigned char *dmem = malloc(destlen);
-        int rc = compress2(dmem, &destlen, tmem, tlen, 9);
-
-	if((rc == Z_OK) && (destlen < tlen))
-		{
-		fstFwrite(dmem, destlen, 1, xc->handle);
-		}
-		else /* comparison between compressed / decompressed len tells if compressed */
-		{
-		fstFwrite(tmem, tlen, 1, xc->handle);
-		destlen = tlen;
-		}
-	free(dmem);
-	fstMunmap(tmem, tlen);
-	fstWriterUint64(xc->handle, tlen);		/* uncompressed */
-	fstWriterUint64(xc->handle, destlen);		/* compressed */
-	fstWriterUint64(xc->handle, xc->tchn_cnt); 	/* number of time items */
+	free(blk->tchn_mem); blk->tchn_mem = NULL;
 	}
 
 xc->tchn_cnt = xc->tchn_idx = 0;
 fseeko(xc->tchn_handle, 0, SEEK_SET);
 fstFtruncate(fileno(xc->tchn_handle), 0);
 
-/* write block trailer */
-endpos = ftello(xc->handle);
-fseeko(xc->handle, xc->section_start, SEEK_SET);
-fstWriterUint64(xc->handle, endpos - xc->section_start); 	/* write block length */
-fseeko(xc->handle, 8, SEEK_CUR);				/* skip begin time */
-fstWriterUint64(xc->handle, xc->curtime); 			/* write end time for section */
-fstWriterUint64(xc->handle, unc_memreq);			/* amount of buffer memory required in reader for full traversal */
-fflush(xc->handle);
-
-fseeko(xc->handle, xc->section_start-1, SEEK_SET);		/* write out FST_BL_VCDATA over FST_BL_SKIP */
-
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-fputc(FST_BL_VCDATA_DYN_ALIAS, xc->handle);
-#else
-fputc(FST_BL_VCDATA, xc->handle);
-#endif
-
-fflush(xc->handle);
-
-fseeko(xc->handle, endpos, SEEK_SET);				/* seek to end of file */
-
-xc->section_header_truncpos = endpos;				/* cache in case of need to truncate */
-if(xc->dump_size_limit)
+if(xc->threads_state == FST_THREADS_RUNNING)
 	{
-	if(endpos >= xc->dump_size_limit)
+	pthread_mutex_lock(&xc->thread_mutex);
+	xc->write_blk = blk;
+	pthread_cond_broadcast(&xc->thread_cond);
+	pthread_mutex_unlock(&xc->thread_mutex);
+
+	if(xc->dump_size_limit)
 		{
-		xc->skip_writing_section_hdr = 1;
-		xc->size_limit_locked = 1;
-		xc->is_initial_time = 1; /* to trick emit value and emit time change */
-#ifdef FST_DEBUG
-		printf("<< dump file size limit reached, stopping dumping >>\n");
-#endif
+		fstWriterWaitBlock(xc);	/* the limit must be seen before more changes are emitted */
 		}
 	}
-
-if(!xc->skip_writing_section_hdr)
+	else
 	{
-	fstWriterEmitSectionHeader(xc);				/* emit next section header */
+	fstWriterWriteBlock(xc, blk);
 	}
-fflush(xc->handle);
 
 xc->already_in_flush = 0;
 }
 
 
+/*
+ * the public flush returns once the block is in the file, as $dumpflush
+ * expects.  the flushes made as the buffers fill up do not wait.
+ */
+void fstWriterFlushContext(void *ctx)
+{
+struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
+
+if(xc)
+	{
+	fstWriterFlushContextPrivate(xc);
+	fstWriterWaitBlock(xc);
+	}
+}
+
+
 /*
  * functions to set miscellaneous header/block information
  */
@@ -1547,9 +1830,12 @@ struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
 if(xc)
         {
 	char s[FST_HDR_DATE_SIZE];
-	off_t fpos = ftello(xc->handle);
+	off_t fpos;
 	int len = strlen(dat);
 
+	fstWriterWaitBlock(xc);
+	fpos = ftello(xc->handle);
+
 	fseeko(xc->handle, FST_HDR_OFFS_DATE, SEEK_SET);
 	memset(s, 0, FST_HDR_DATE_SIZE);
 	memcpy(s, dat, (len < FST_HDR_DATE_SIZE) ? len : FST_HDR_DATE_SIZE);
@@ -1566,9 +1852,12 @@ struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
 if(xc && vers)
         {
 	char s[FST_HDR_SIM_VERSION_SIZE];
-	off_t fpos = ftello(xc->handle);
+	off_t fpos;
 	int len = strlen(vers);
 
+	fstWriterWaitBlock(xc);
+	fpos = ftello(xc->handle);
+
 	fseeko(xc->handle, FST_HDR_OFFS_SIM_VERSION, SEEK_SET);
 	memset(s, 0, FST_HDR_SIM_VERSION_SIZE);
 	memcpy(s, vers, (len < FST_HDR_SIM_VERSION_SIZE) ? len : FST_HDR_SIM_VERSION_SIZE);
@@ -1584,7 +1873,10 @@ void fstWriterSetTimescale(void *ctx, int ts)
 struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
 if(xc)
         {
-	off_t fpos = ftello(xc->handle);
+	off_t fpos;
+
+	fstWriterWaitBlock(xc);
+	fpos = ftello(xc->handle);
 	fseeko(xc->handle, FST_HDR_OFFS_TIMESCALE, SEEK_SET);
 	fputc(ts & 255, xc->handle);
 	fflush(xc->handle);
@@ -1647,6 +1939,26 @@ if(xc)
 }
 
 
+void fstWriterSetCompressionLevel(void *ctx, int level)
+{
+struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
+if(xc && (level >= 0) && (level <= 9))
+	{
+	xc->compress_level = level;
+	}
+}
+
+
+void fstWriterSetCompressionWorkers(void *ctx, int workers)
+{
+struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
+if(xc && (workers >= 0) && (xc->threads_state == FST_THREADS_UNSTARTED))
+	{
+	xc->compress_workers = workers;
+	}
+}
+
+
 void fstWriterSetRepackOnClose(void *ctx, int enable)
 {
 struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
@@ -1930,7 +2242,7 @@ if(xc)
 		xc->curtime = 0;
 		xc->vchg_mem[0] = '!';
 		xc->vchg_siz = 1;
-		fstWriterEmitSectionHeader(xc);
+		fstWriterEmitSectionHeader(xc, xc->firsttime, xc->curtime, xc->maxvalpos, xc->maxhandle);
 		for(i=0;i<xc->maxhandle;i++)
 			{
 			xc->valpos_mem[4*i+2] = 0; /* zero out offset val */
@@ -1942,7 +2254,7 @@ if(xc)
 		{
 		if(xc->vchg_siz >= FST_BREAK_SIZE)
 			{
-			fstWriterFlushContext(xc);
+			fstWriterFlushContextPrivate(xc);
 			xc->tchn_cnt++;
 			fstWriterVarint(xc->tchn_handle, xc->curtime);
 			}
@@ -148,6 +148,8 @@ fstHandle fstWriterCreateVar(void *ctx, enum fstVarType vt, enum fstVarDir vd,
 
 void fstWriterSetPackType(void *ctx, int typ); 		/* type = 0 (libz), 1 (fastlz) */
 void fstWriterSetRepackOnClose(void *ctx, int enable); 	/* type = 0 (none), 1 (libz) */
+void fstWriterSetCompressionLevel(void *ctx, int level);	/* libz level 0..9, default 4 */
+void fstWriterSetCompressionWorkers(void *ctx, int workers);	/* 0 = none, default 1 = writer thread */
 void fstWriterSetDumpSizeLimit(void *ctx, uint64_t numbytes);
 int fstWriterGetDumpSizeLimitReached(void *ctx);
 
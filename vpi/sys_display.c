@@ -59,6 +59,9 @@ struct strobe_cb_info {
       vpiHandle*items;
       unsigned nitems;
       unsigned fd_mcd;
+      struct display_arg_s*args;
+	/* The format of $sformat, if it is a constant string. */
+      struct format_plan_s*format;
 };
 
 /*
@@ -802,115 +805,203 @@ static unsigned int get_format_char(char **rtn, int ljust, int plus,
   return size - 1;
 }
 
-/* We can't use the normal str functions on the return value since
- * %u and %z can insert NULL characters into the stream. */
-static unsigned int get_format(char **rtn, char *fmt,
-                               const struct strobe_cb_info *info, unsigned int *idx)
+/*
+ * The text of a display is assembled in this buffer. The buffer is
+ * kept from one display to the next so that it only has to grow.
+ */
+static char *disp_buf = 0;
+static unsigned int disp_size = 0;
+static unsigned int disp_alloc = 0;
+
+/* Make room for cnt more characters (and a trailing NULL) in the
+ * display buffer, and return a pointer to the end of the text. */
+static char *disp_reserve(unsigned int cnt)
 {
-  char *cp = fmt;
-  unsigned int size;
+  if (disp_size+cnt+1 > disp_alloc) {
+    disp_alloc = 2*(disp_size+cnt+1);
+    if (disp_alloc < 256) disp_alloc = 256;
+    disp_buf = realloc(disp_buf, disp_alloc*sizeof(char));
+  }
+  return disp_buf + disp_size;
+}
+
+static void disp_append(const char *text, unsigned int cnt)
+{
+  memcpy(disp_reserve(cnt), text, cnt);
+  disp_size += cnt;
+}
+
+/* Append the string right justified in a field of the given width. */
+static void disp_append_right(const char *text, unsigned int width)
+{
+  unsigned int len = strlen(text);
+  if (len < width) {
+    memset(disp_reserve(width-len), ' ', width-len);
+    disp_size += width - len;
+  }
+  disp_append(text, len);
+}
+
+/*
+ * A format string is parsed once into a list of pieces. A piece is
+ * either literal text, or a single conversion with its flags.
+ */
+struct format_piece_s {
+      const char *text;
+      unsigned int len;
+      int ljust, plus, ld_zero, width, prec;
+      char fmt;
+};
+
+struct format_plan_s {
+	/* The literal pieces point into this copy of the format. */
+      char *text;
+      struct format_piece_s *pieces;
+      unsigned int npieces;
+};
 
-  *rtn = strdup("");
-  size = 1;
+static struct format_plan_s *compile_format(const char *fmt)
+{
+  struct format_plan_s *plan = malloc(sizeof(struct format_plan_s));
+  char *cp;
+
+  plan->text = strdup(fmt);
+  plan->pieces = 0;
+  plan->npieces = 0;
+
+  cp = plan->text;
   while (*cp) {
     size_t cnt = strcspn(cp, "%");
+    struct format_piece_s *cur;
+
+    plan->pieces = realloc(plan->pieces,
+                           (plan->npieces+1)*sizeof(struct format_piece_s));
+    cur = plan->pieces + plan->npieces;
+    plan->npieces += 1;
 
     if (cnt > 0) {
-      *rtn = realloc(*rtn, (size+cnt)*sizeof(char));
-      memcpy(*rtn+size-1, cp, cnt);
-      size += cnt;
+      cur->text = cp;
+      cur->len = cnt;
       cp += cnt;
     } else {
-      int ljust = 0, plus = 0, ld_zero = 0, width = -1, prec = -1;
-      char *result;
+      cur->text = 0;
+      cur->len = 0;
+      cur->ljust = 0;
+      cur->plus = 0;
+      cur->ld_zero = 0;
+      cur->width = -1;
+      cur->prec = -1;
 
       cp += 1;
       while ((*cp == '-') || (*cp == '+')) {
-        if (*cp == '-') ljust = 1;
-        else plus = 1;
+        if (*cp == '-') cur->ljust = 1;
+        else cur->plus = 1;
         cp += 1;
       }
       if (*cp == '0') {
-        ld_zero = 1;
+        cur->ld_zero = 1;
         cp += 1;
       }
-      if (isdigit((int)*cp)) width = strtoul(cp, &cp, 10);
+      if (isdigit((int)*cp)) cur->width = strtoul(cp, &cp, 10);
       if (*cp == '.') {
         cp += 1;
-        prec = strtoul(cp, &cp, 10);
+        cur->prec = strtoul(cp, &cp, 10);
       }
-      cnt = get_format_char(&result, ljust, plus, ld_zero, width, prec, *cp,
-                            info, idx);
-      *rtn = realloc(*rtn, (size+cnt)*sizeof(char));
-      memcpy(*rtn+size-1, result, cnt);
-      free(result);
-      size += cnt;
-      cp += 1;
+      cur->fmt = *cp;
+      if (*cp) cp += 1;
     }
   }
-  *(*rtn+size-1) = '\0';
-  return size - 1;
+
+  return plan;
 }
 
-static unsigned int get_numeric(char **rtn, const struct strobe_cb_info *info,
-                                vpiHandle item)
+static void free_format(struct format_plan_s *plan)
 {
-  int size;
-  s_vpi_value val;
+  free(plan->pieces);
+  free(plan->text);
+  free(plan);
+}
 
-  val.format = info->default_format;
-  vpi_get_value(item, &val);
+/* We can't use the normal str functions on the display text since
+ * %u and %z can insert NULL characters into the stream. */
+static void render_format(const struct format_plan_s *plan,
+                          const struct strobe_cb_info *info, unsigned int *idx)
+{
+  unsigned int pdx;
 
-  switch(info->default_format){
-    case vpiDecStrVal:
-      size = vpi_get_dec_size(item);
-      *rtn = malloc((size+1)*sizeof(char));
-      sprintf(*rtn, "%*s", size, val.value.str);
-      break;
-    default:
-      *rtn = strdup(val.value.str);
-  }
+  for (pdx = 0; pdx < plan->npieces; pdx += 1) {
+    const struct format_piece_s *cur = plan->pieces + pdx;
+    char *result;
+    unsigned int cnt;
 
-  return strlen(*rtn);
+    if (cur->text) {
+      disp_append(cur->text, cur->len);
+      continue;
+    }
+
+    cnt = get_format_char(&result, cur->ljust, cur->plus, cur->ld_zero,
+                          cur->width, cur->prec, cur->fmt, info, idx);
+    disp_append(result, cnt);
+    free(result);
+  }
 }
 
-/* In many places we can't use the normal str functions since %u and %z
- * can insert NULL characters into the stream. */
-static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
+/*
+ * The arguments of a display are sorted into these kinds when the
+ * argument list is collected, so that each display only needs to
+ * get the values.
+ */
+enum display_arg_kind {
+      DISP_ARG_FORMAT,
+      DISP_ARG_REAL,
+      DISP_ARG_NUMERIC,
+      DISP_ARG_TIMEVAR,
+      DISP_ARG_TIME,
+      DISP_ARG_STIME,
+      DISP_ARG_SIMTIME,
+      DISP_ARG_REALTIME,
+      DISP_ARG_BAD_FUNC,
+      DISP_ARG_UNKNOWN
+};
+
+struct display_arg_s {
+      enum display_arg_kind kind;
+	/* The decimal field width of a numeric argument, or the
+	 * precision of a $realtime argument. */
+      int size;
+	/* The parsed format of a string constant argument. */
+      struct format_plan_s *plan;
+};
+
+static void plan_display_args(struct strobe_cb_info *info)
 {
-  char *result, *fmt, *rtn, *func_name;
-  const char *cresult;
-  s_vpi_value value;
-  unsigned int idx, size, width;
-  char buf[256];
+  unsigned int idx;
 
-  rtn = strdup("");
-  size = 1;
-  for  (idx = 0; idx < info->nitems; idx += 1) {
+  if (info->nitems == 0) {
+    info->args = 0;
+    return;
+  }
+
+  info->args = calloc(info->nitems, sizeof(struct display_arg_s));
+  for (idx = 0; idx < info->nitems; idx += 1) {
     vpiHandle item = info->items[idx];
+    struct display_arg_s *arg = info->args + idx;
+    s_vpi_value value;
+    char *func_name;
 
+    arg->kind = DISP_ARG_NUMERIC;
     switch (vpi_get(vpiType, item)) {
 
       case vpiConstant:
       case vpiParameter:
         if (vpi_get(vpiConstType, item) == vpiStringConst) {
+          arg->kind = DISP_ARG_FORMAT;
           value.format = vpiStringVal;
           vpi_get_value(item, &value);
-          fmt = strdup(value.value.str);
-          width = get_format(&result, fmt, info, &idx);
-          free(fmt);
+          arg->plan = compile_format(value.value.str);
         } else if (vpi_get(vpiConstType, item) == vpiRealConst) {
-          value.format = vpiRealVal;
-          vpi_get_value(item, &value);
-          sprintf(buf, "%#g", value.value.real);
-          result = strdup(buf);
-          width = strlen(result);
-        } else {
-          width = get_numeric(&result, info, item);
+          arg->kind = DISP_ARG_REAL;
         }
-        rtn = realloc(rtn, (size+width)*sizeof(char));
-        memcpy(rtn+size-1, result, width);
-        free(result);
         break;
 
       case vpiNet:
@@ -918,99 +1009,161 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
       case vpiIntegerVar:
       case vpiMemoryWord:
       case vpiPartSelect:
-        width = get_numeric(&result, info, item);
-        rtn = realloc(rtn, (size+width)*sizeof(char));
-        memcpy(rtn+size-1, result, width);
-        free(result);
         break;
 
       /* It appears that this is not currently used! A time variable is
          passed as an integer and processed above. Hence this code has
          only been visually checked. */
       case vpiTimeVar:
-        value.format = vpiDecStrVal;
-        vpi_get_value(item, &value);
-        get_time(buf, value.value.str, timeformat_info.prec,
-                 vpi_get(vpiTimeUnit, info->scope));
-        width = strlen(buf);
-        if (width  < timeformat_info.width) width = timeformat_info.width;
-        rtn = realloc(rtn, (size+width)*sizeof(char));
-        sprintf(rtn+size-1, "%*s", width, buf);
+        arg->kind = DISP_ARG_TIMEVAR;
         break;
 
       /* Realtime variables are also processed here. */
       case vpiRealVar:
-        value.format = vpiRealVal;
-        vpi_get_value(item, &value);
-        sprintf(buf, "%#g", value.value.real);
-        width = strlen(buf);
-        rtn = realloc(rtn, (size+width)*sizeof(char));
-        memcpy(rtn+size-1, buf, width);
+        arg->kind = DISP_ARG_REAL;
         break;
 
       case vpiSysFuncCall:
         func_name = vpi_get_str(vpiName, item);
         if (strcmp(func_name, "$time") == 0) {
-          value.format = vpiDecStrVal;
-          vpi_get_value(item, &value);
-          width = strlen(value.value.str);
-          if (width  < 20) width = 20;
-          rtn = realloc(rtn, (size+width)*sizeof(char));
-          sprintf(rtn+size-1, "%*s", width, value.value.str);
-
+          arg->kind = DISP_ARG_TIME;
         } else if (strcmp(func_name, "$stime") == 0) {
-          value.format = vpiDecStrVal;
-          vpi_get_value(item, &value);
-          width = strlen(value.value.str);
-          if (width  < 10) width = 10;
-          rtn = realloc(rtn, (size+width)*sizeof(char));
-          sprintf(rtn+size-1, "%*s", width, value.value.str);
-
+          arg->kind = DISP_ARG_STIME;
         } else if (strcmp(func_name, "$simtime") == 0) {
-          value.format = vpiDecStrVal;
-          vpi_get_value(item, &value);
-          width = strlen(value.value.str);
-          if (width  < 20) width = 20;
-          rtn = realloc(rtn, (size+width)*sizeof(char));
-          sprintf(rtn+size-1, "%*s", width, value.value.str);
-
+          arg->kind = DISP_ARG_SIMTIME;
         } else if (strcmp(func_name, "$realtime") == 0) {
           /* Use the local scope precision. */
-          int use_prec = vpi_get(vpiTimeUnit, info->scope) -
-                         vpi_get(vpiTimePrecision, info->scope);
-          assert(use_prec >= 0);
-          value.format = vpiRealVal;
-          vpi_get_value(item, &value);
-          sprintf(buf, "%.*f", use_prec, value.value.real);
-          width = strlen(buf);
-          rtn = realloc(rtn, (size+width)*sizeof(char));
-          sprintf(rtn+size-1, "%*s", width, buf);
-
+          arg->kind = DISP_ARG_REALTIME;
+          arg->size = vpi_get(vpiTimeUnit, info->scope) -
+                      vpi_get(vpiTimePrecision, info->scope);
+          assert(arg->size >= 0);
         } else {
-          vpi_printf("WARNING: %s:%d: %s does not support %s as an argument!\n",
-                     info->filename, info->lineno, info->name, func_name);
-          strcpy(buf, "<?>");
-          width = strlen(buf);
-          rtn = realloc(rtn, (size+width)*sizeof(char));
-          memcpy(rtn+size-1, buf, width);
+          arg->kind = DISP_ARG_BAD_FUNC;
         }
         break;
 
       default:
+        arg->kind = DISP_ARG_UNKNOWN;
+        break;
+    }
+
+    if (arg->kind == DISP_ARG_NUMERIC &&
+        info->default_format == vpiDecStrVal) {
+      arg->size = vpi_get_dec_size(item);
+    }
+  }
+}
+
+static void free_display_args(struct strobe_cb_info *info)
+{
+  unsigned int idx;
+
+  if (info->args == 0) return;
+
+  for (idx = 0; idx < info->nitems; idx += 1) {
+    if (info->args[idx].plan) free_format(info->args[idx].plan);
+  }
+  free(info->args);
+  info->args = 0;
+}
+
+static void get_numeric(const struct strobe_cb_info *info,
+                        const struct display_arg_s *arg, vpiHandle item)
+{
+  s_vpi_value val;
+
+  val.format = info->default_format;
+  vpi_get_value(item, &val);
+
+  switch(info->default_format){
+    case vpiDecStrVal:
+      disp_append_right(val.value.str, arg->size);
+      break;
+    default:
+      disp_append(val.value.str, strlen(val.value.str));
+  }
+}
+
+/*
+ * Render the display into the display buffer and return it. The text
+ * is only good until the next display. In many places we can't use
+ * the normal str functions since %u and %z can insert NULL characters
+ * into the stream.
+ */
+static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
+{
+  s_vpi_value value;
+  unsigned int idx;
+  char buf[256];
+
+  disp_size = 0;
+  for  (idx = 0; idx < info->nitems; idx += 1) {
+    vpiHandle item = info->items[idx];
+    const struct display_arg_s *arg = info->args + idx;
+
+    switch (arg->kind) {
+
+      case DISP_ARG_FORMAT:
+        render_format(arg->plan, info, &idx);
+        break;
+
+      case DISP_ARG_REAL:
+        value.format = vpiRealVal;
+        vpi_get_value(item, &value);
+        sprintf(buf, "%#g", value.value.real);
+        disp_append(buf, strlen(buf));
+        break;
+
+      case DISP_ARG_NUMERIC:
+        get_numeric(info, arg, item);
+        break;
+
+      case DISP_ARG_TIMEVAR:
+        value.format = vpiDecStrVal;
+        vpi_get_value(item, &value);
+        get_time(buf, value.value.str, timeformat_info.prec,
+                 vpi_get(vpiTimeUnit, info->scope));
+        disp_append_right(buf, timeformat_info.width);
+        break;
+
+      case DISP_ARG_TIME:
+      case DISP_ARG_SIMTIME:
+        value.format = vpiDecStrVal;
+        vpi_get_value(item, &value);
+        disp_append_right(value.value.str, 20);
+        break;
+
+      case DISP_ARG_STIME:
+        value.format = vpiDecStrVal;
+        vpi_get_value(item, &value);
+        disp_append_right(value.value.str, 10);
+        break;
+
+      case DISP_ARG_REALTIME:
+        value.format = vpiRealVal;
+        vpi_get_value(item, &value);
+        sprintf(buf, "%.*f", arg->size, value.value.real);
+        disp_append(buf, strlen(buf));
+        break;
+
+      case DISP_ARG_BAD_FUNC:
+        vpi_printf("WARNING: %s:%d: %s does not support %s as an argument!\n",
+                   info->filename, info->lineno, info->name,
+                   vpi_get_str(vpiName, item));
+        disp_append("<?>", 3);
+        break;
+
+      case DISP_ARG_UNKNOWN:
         vpi_printf("WARNING: %s:%d: unknown argument type (%s) given to %s!\n",
                    info->filename, info->lineno, vpi_get_str(vpiType, item),
                    info->name);
-        cresult = "<?>";
-        width = strlen(cresult);
-        rtn = realloc(rtn, (size+width)*sizeof(char));
-        memcpy(rtn+size-1, cresult, width);
+        disp_append("<?>", 3);
         break;
     }
-    size += width;
   }
-  rtn[size-1] = '\0';
-  *rtnsz = size - 1;
-  return rtn;
+  *disp_reserve(0) = '\0';
+  *rtnsz = disp_size;
+  return disp_buf;
 }
 
 static int sys_check_args(vpiHandle callh, vpiHandle argv, const PLI_BYTE8*name,
@@ -1106,68 +1259,96 @@ static PLI_INT32 sys_common_compiletf(ICARUS_VPI_CONST PLI_BYTE8*name, int no_au
       return 0;
 }
 
+/*
+ * The $display, $write, $swrite based and severity tasks collect their
+ * display arguments when they are compiled and keep them with the call,
+ * so that each call only has to get the values. The first skip arguments
+ * (the file descriptor/MCD or the output register) are not displayed.
+ */
+static struct strobe_cb_info *make_display_info(vpiHandle callh,
+                                                const char *name,
+                                                unsigned skip,
+                                                int default_format)
+{
+      vpiHandle argv = vpi_iterate(vpiArgument, callh);
+      struct strobe_cb_info *info = calloc(1, sizeof(struct strobe_cb_info));
+
+      while (argv && skip > 0) {
+	    if (vpi_scan(argv) == 0) argv = 0;
+	    skip -= 1;
+      }
+
+	/* We could use vpi_get_str(vpiName, callh) to get the task name,
+	 * but name is already defined. */
+      info->name = name;
+      info->filename = strdup(vpi_get_str(vpiFile, callh));
+      info->lineno = (int)vpi_get(vpiLineNo, callh);
+      info->default_format = default_format;
+      info->scope = vpi_handle(vpiScope, callh);
+      assert(info->scope);
+      array_from_iterator(info, argv);
+      plan_display_args(info);
+
+      vpi_put_userdata(callh, info);
+      return info;
+}
+
 /* Check the $display, $write, $fdisplay and $fwrite based tasks. */
 static PLI_INT32 sys_display_compiletf(ICARUS_VPI_CONST PLI_BYTE8*name)
 {
+      vpiHandle callh = vpi_handle(vpiSysTfCall, 0);
+
 	/* These tasks can have automatic variables and are not monitor. */
-      return sys_common_compiletf(name, 0, 0);
+      sys_common_compiletf(name, 0, 0);
+
+      make_display_info(callh, name, name[1] == 'f' ? 1 : 0,
+                        get_default_format(name));
+      return 0;
 }
 
 /* This implements the $display/$fdisplay and the $write/$fwrite based tasks. */
 static PLI_INT32 sys_display_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
 {
-      vpiHandle callh, argv, scope;
-      struct strobe_cb_info info;
+      vpiHandle callh;
+      struct strobe_cb_info *info;
       char* result;
       unsigned int size, location=0;
       PLI_UINT32 fd_mcd;
 
       callh = vpi_handle(vpiSysTfCall, 0);
-      argv = vpi_iterate(vpiArgument, callh);
+      info = vpi_get_userdata(callh);
+      assert(info);
 
 	/* Get the file/MC descriptor and verify it is valid. */
       if(name[1] == 'f') {
-	      errno = 0;
+	      vpiHandle argv = vpi_iterate(vpiArgument, callh);
 	      vpiHandle arg = vpi_scan(argv);
 	      s_vpi_value val;
+	      vpi_free_object(argv);
+	      errno = 0;
 	      val.format = vpiIntVal;
 	      vpi_get_value(arg, &val);
 	      fd_mcd = val.value.integer;
 
 		/* If the MCD is zero we have nothing to do so just return. */
-	      if (fd_mcd == 0)  {
-		    vpi_free_object(argv);
-		    return 0;
-	      }
+	      if (fd_mcd == 0) return 0;
 
 	      if ((! IS_MCD(fd_mcd) && vpi_get_file(fd_mcd) == NULL) ||
 	          ( IS_MCD(fd_mcd) && my_mcd_printf(fd_mcd, "") == EOF)) {
-		    vpi_printf("WARNING: %s:%d: ", vpi_get_str(vpiFile, callh),
-		               (int)vpi_get(vpiLineNo, callh));
+		    vpi_printf("WARNING: %s:%d: ", info->filename,
+		               info->lineno);
 		    vpi_printf("invalid file descriptor/MCD (0x%x) given "
 		               "to %s.\n", (unsigned int)fd_mcd, name);
 		    errno = EBADF;
-		    vpi_free_object(argv);
 		    return 0;
 	      }
       } else {
 	      fd_mcd = 1;
       }
 
-      scope = vpi_handle(vpiScope, callh);
-      assert(scope);
-	/* We could use vpi_get_str(vpiName, callh) to get the task name,
-	 * but name is already defined. */
-      info.name = name;
-      info.filename = strdup(vpi_get_str(vpiFile, callh));
-      info.lineno = (int)vpi_get(vpiLineNo, callh);
-      info.default_format = get_default_format(name);
-      info.scope = scope;
-      array_from_iterator(&info, argv);
-
 	/* Because %u and %z may put embedded NULL characters into the
 	 * returned string strlen() may not match the real size! */
-      result = get_display(&size, &info);
+      result = get_display(&size, info);
       while (location < size) {
 	    if (result[location] == '\0') {
 		  my_mcd_printf(fd_mcd, "%c", '\0');
@@ -1180,9 +1361,6 @@ static PLI_INT32 sys_display_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
       if ((strncmp(name,"$display",8) == 0) ||
           (strncmp(name,"$fdisplay",9) == 0)) my_mcd_printf(fd_mcd, "\n");
 
-      free(info.filename);
-      free(info.items);
-      free(result);
       return 0;
 }
 
@@ -1217,9 +1395,9 @@ static PLI_INT32 strobe_cb(p_cb_data cb)
 		  }
 	    }
 	    my_mcd_printf(info->fd_mcd, "\n");
-	    free(result);
       }
 
+      free_display_args(info);
       free(info->filename);
       free(info->items);
       free(info);
@@ -1287,6 +1465,7 @@ static PLI_INT32 sys_strobe_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       info->default_format = get_default_format(name);
       info->scope= scope;
       array_from_iterator(info, argv);
+      plan_display_args(info);
 
       timerec.type = vpiSimTime;
       timerec.low = 0;
@@ -1310,7 +1489,7 @@ static PLI_INT32 sys_strobe_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
  * though that monitor may be watching many variables).
  */
 
-static struct strobe_cb_info monitor_info = { 0, 0, 0, 0, 0, 0, 0, 0 };
+static struct strobe_cb_info monitor_info = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 static vpiHandle *monitor_callbacks = 0;
 static int monitor_scheduled = 0;
 static int monitor_enabled = 1;
@@ -1334,7 +1513,6 @@ static PLI_INT32 monitor_cb_2(p_cb_data cb)
       }
       my_mcd_printf(monitor_info.fd_mcd, "\n");
       monitor_scheduled = 0;
-      free(result);
       return 0;
 }
 
@@ -1399,6 +1577,7 @@ static PLI_INT32 sys_monitor_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 	    free(monitor_callbacks);
 	    monitor_callbacks = 0;
 
+	    free_display_args(&monitor_info);
 	    free(monitor_info.filename);
 	    free(monitor_info.items);
 	    monitor_info.items = 0;
@@ -1416,6 +1595,7 @@ static PLI_INT32 sys_monitor_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       monitor_info.default_format = get_default_format(name);
       monitor_info.scope = scope;
       monitor_info.fd_mcd = 1;
+      plan_display_args(&monitor_info);
 
 	/* Attach callbacks to all the parameters that might change. */
       monitor_callbacks = calloc(monitor_info.nitems, sizeof(vpiHandle));
@@ -1497,44 +1677,35 @@ static PLI_INT32 sys_swrite_compiletf(ICARUS_VPI_CONST PLI_BYTE8 *name)
   }
 
   if (sys_check_args(callh, argv, name, 0, 0)) vpi_control(vpiFinish, 1);
+
+  make_display_info(callh, name, 1, get_default_format(name));
   return 0;
 }
 
 static PLI_INT32 sys_swrite_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
 {
-  vpiHandle callh, argv, reg, scope;
-  struct strobe_cb_info info;
+  vpiHandle callh, argv, reg;
+  struct strobe_cb_info *info;
   s_vpi_value val;
   unsigned int size;
 
   callh = vpi_handle(vpiSysTfCall, 0);
+  info = vpi_get_userdata(callh);
+  assert(info);
   argv = vpi_iterate(vpiArgument, callh);
   reg = vpi_scan(argv);
-
-  scope = vpi_handle(vpiScope, callh);
-  assert(scope);
-  /* We could use vpi_get_str(vpiName, callh) to get the task name, but
-   * name is already defined. */
-  info.name = name;
-  info.filename = strdup(vpi_get_str(vpiFile, callh));
-  info.lineno = (int)vpi_get(vpiLineNo, callh);
-  info.default_format = get_default_format(name);
-  info.scope = scope;
-  array_from_iterator(&info, argv);
+  vpi_free_object(argv);
 
   /* Because %u and %z may put embedded NULL characters into the returned
    * string strlen() may not match the real size! */
-  val.value.str = get_display(&size, &info);
+  val.value.str = get_display(&size, info);
   val.format = vpiStringVal;
   vpi_put_value(reg, &val, 0, vpiNoDelay);
   if (size != strlen(val.value.str)) {
     vpi_printf("WARNING: %s:%d: %s returned a value with an embedded NULL "
-               "(see %%u/%%z).\n", info.filename, info.lineno, name);
+               "(see %%u/%%z).\n", info->filename, info->lineno, name);
   }
 
-  free(val.value.str);
-  free(info.filename);
-  free(info.items);
   return 0;
 }
 
@@ -1544,6 +1715,7 @@ static PLI_INT32 sys_sformat_compiletf(ICARUS_VPI_CONST PLI_BYTE8 *name)
   vpiHandle argv = vpi_iterate(vpiArgument, callh);
   vpiHandle arg;
   PLI_INT32 type;
+  struct strobe_cb_info *info;
 
   /* Check that there are arguments. */
   if (argv == 0) {
@@ -1584,55 +1756,62 @@ static PLI_INT32 sys_sformat_compiletf(ICARUS_VPI_CONST PLI_BYTE8 *name)
   }
 
   if (sys_check_args(callh, argv, name, 0, 0)) vpi_control(vpiFinish, 1);
+
+  /* A constant format is parsed here, once. The format register is
+   * parsed each call. */
+  info = make_display_info(callh, name, 2, get_default_format(name));
+  if (type != vpiReg) {
+    s_vpi_value val;
+    val.format = vpiStringVal;
+    vpi_get_value(arg, &val);
+    info->format = compile_format(val.value.str);
+  }
   return 0;
 }
 
 static PLI_INT32 sys_sformat_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
 {
-  vpiHandle callh, argv, reg, scope;
-  struct strobe_cb_info info;
+  vpiHandle callh, argv, reg, fmt;
+  struct strobe_cb_info *info;
+  struct format_plan_s *plan;
   s_vpi_value val;
-  char *result, *fmt;
-  unsigned int idx, size;
+  unsigned int idx;
 
   callh = vpi_handle(vpiSysTfCall, 0);
+  info = vpi_get_userdata(callh);
+  assert(info);
   argv = vpi_iterate(vpiArgument, callh);
   reg = vpi_scan(argv);
-  val.format = vpiStringVal;
-  vpi_get_value(vpi_scan(argv), &val);
-  fmt = strdup(val.value.str);
-
-  scope = vpi_handle(vpiScope, callh);
-  assert(scope);
-  /* We could use vpi_get_str(vpiName, callh) to get the task name, but
-   * name is already defined. */
-  info.name = name;
-  info.filename = strdup(vpi_get_str(vpiFile, callh));
-  info.lineno = (int)vpi_get(vpiLineNo, callh);
-  info.default_format = get_default_format(name);
-  info.scope = scope;
-  array_from_iterator(&info, argv);
+  fmt = vpi_scan(argv);
+  vpi_free_object(argv);
+
+  plan = info->format;
+  if (plan == 0) {
+    val.format = vpiStringVal;
+    vpi_get_value(fmt, &val);
+    plan = compile_format(val.value.str);
+  }
+
   idx = -1;
-  size = get_format(&result, fmt, &info, &idx);
-  free(fmt);
+  disp_size = 0;
+  render_format(plan, info, &idx);
+  *disp_reserve(0) = '\0';
+  if (plan != info->format) free_format(plan);
 
-  if (idx+1< info.nitems) {
+  if (idx+1< info->nitems) {
     vpi_printf("WARNING: %s:%d: %s has %d extra argument(s).\n",
-               info.filename, info.lineno,  name,
-               info.nitems-idx-1);
+               info->filename, info->lineno,  name,
+               info->nitems-idx-1);
   }
 
-  val.value.str = result;
+  val.value.str = disp_buf;
   val.format = vpiStringVal;
   vpi_put_value(reg, &val, 0, vpiNoDelay);
-  if (size != strlen(val.value.str)) {
+  if (disp_size != strlen(val.value.str)) {
     vpi_printf("WARNING: %s:%d: %s returned a value with an embedded NULL "
-               "(see %%u/%%z).\n", info.filename, info.lineno, name);
+               "(see %%u/%%z).\n", info->filename, info->lineno, name);
   }
 
-  free(val.value.str);
-  free(info.filename);
-  free(info.items);
   return 0;
 }
 
@@ -1855,11 +2034,19 @@ static PLI_INT32 sys_printtimescale_calltf(ICARUS_VPI_CONST PLI_BYTE8*xx)
       return 0;
 }
 
-static PLI_INT32 sys_fatal_compiletf(ICARUS_VPI_CONST PLI_BYTE8*name)
+/* Check the severity tasks. The $fatal finish number is not displayed. */
+static PLI_INT32 sys_severity_compiletf(ICARUS_VPI_CONST PLI_BYTE8*name)
 {
       vpiHandle callh = vpi_handle(vpiSysTfCall, 0);
-      vpiHandle argv = vpi_iterate(vpiArgument, callh);
+      vpiHandle argv;
 
+      if (strncmp(name,"$fatal", 6) != 0) {
+	    sys_common_compiletf(name, 0, 0);
+	    make_display_info(callh, name, 0, vpiDecStrVal);
+	    return 0;
+      }
+
+      argv = vpi_iterate(vpiArgument, callh);
       if (argv) {
             vpiHandle arg = vpi_scan(argv);
 
@@ -1876,33 +2063,38 @@ static PLI_INT32 sys_fatal_compiletf(ICARUS_VPI_CONST PLI_BYTE8*name)
 	    }
       }
 
+      make_display_info(callh, name, 1, vpiDecStrVal);
       return 0;
 }
 
 static PLI_INT32 sys_severity_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 {
       vpiHandle callh = vpi_handle(vpiSysTfCall, 0);
-      vpiHandle argv = vpi_iterate(vpiArgument, callh);
-      vpiHandle scope;
-      struct strobe_cb_info info;
+      struct strobe_cb_info *info;
       struct t_vpi_time now;
       PLI_UINT64 now64;
       char *sstr, *t, *dstr;
       unsigned int size, location=0;
       s_vpi_value finish_number;
 
+      info = vpi_get_userdata(callh);
+      assert(info);
+
       /* Set the default finish number for $fatal. */
       finish_number.value.integer = 1;
 
       /* Check that the finish number is in range. */
-      if (strncmp(name,"$fatal", 6) == 0 && argv) {
-            vpiHandle arg = vpi_scan(argv);
-            finish_number.format = vpiIntVal;
-            vpi_get_value(arg, &finish_number);
+      if (strncmp(name,"$fatal", 6) == 0) {
+            vpiHandle argv = vpi_iterate(vpiArgument, callh);
+            if (argv) {
+                  vpiHandle arg = vpi_scan(argv);
+                  vpi_free_object(argv);
+                  finish_number.format = vpiIntVal;
+                  vpi_get_value(arg, &finish_number);
+            }
             if ((finish_number.value.integer < 0) ||
 		(finish_number.value.integer > 2)) {
-                  vpi_printf("WARNING: %s:%d: ", vpi_get_str(vpiFile, callh),
-                             (int)vpi_get(vpiLineNo, callh));
+                  vpi_printf("WARNING: %s:%d: ", info->filename, info->lineno);
                   vpi_printf("$fatal called with finish_number of %d, "
 			     "but it must be 0, 1, or 2.\n",
 			     (int)finish_number.value.integer);
@@ -1914,18 +2106,9 @@ static PLI_INT32 sys_severity_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       sstr = strdup(name) + 1;
       for (t=sstr; *t; t+=1) *t = toupper((int)*t);
 
-      scope = vpi_handle(vpiScope, callh);
-      assert(scope);
-      info.name = name;
-      info.filename = strdup(vpi_get_str(vpiFile, callh));
-      info.lineno = (int)vpi_get(vpiLineNo, callh);
-      info.default_format = vpiDecStrVal;
-      info.scope = scope;
-      array_from_iterator(&info, argv);
-
-      vpi_printf("%s: %s:%d: ", sstr, info.filename, info.lineno);
+      vpi_printf("%s: %s:%d: ", sstr, info->filename, info->lineno);
 
-      dstr = get_display(&size, &info);
+      dstr = get_display(&size, info);
       while (location < size) {
 	    if (dstr[location] == '\0') {
 		  my_mcd_printf(1, "%c", '\0');
@@ -1942,12 +2125,9 @@ static PLI_INT32 sys_severity_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 
       vpi_printf("\n%*s  Time: %" PLI_UINT64_FMT " Scope: %s\n",
                  (int)strlen(sstr), " ", now64,
-                 vpi_get_str(vpiFullName, scope));
+                 vpi_get_str(vpiFullName, info->scope));
 
       free(--sstr);  /* Get the $ back. */
-      free(info.filename);
-      free(info.items);
-      free(dstr);
 
       if (strncmp(name,"$fatal",6) == 0) {
             vpi_control(vpiFinish, finish_number.value.integer);
@@ -1961,6 +2141,7 @@ static PLI_INT32 sys_end_of_simulation(p_cb_data cb_data)
 {
       free(monitor_callbacks);
       monitor_callbacks = 0;
+      free_display_args(&monitor_info);
       free(monitor_info.filename);
       free(monitor_info.items);
       monitor_info.items = 0;
@@ -2324,7 +2505,7 @@ void sys_display_register()
       tf_data.type      = vpiSysTask;
       tf_data.tfname    = "$fatal";
       tf_data.calltf    = sys_severity_calltf;
-      tf_data.compiletf = sys_fatal_compiletf;
+      tf_data.compiletf = sys_severity_compiletf;
       tf_data.sizetf    = 0;
       tf_data.user_data = "$fatal";
       res = vpi_register_systf(&tf_data);
@@ -2333,7 +2514,7 @@ void sys_display_register()
       tf_data.type      = vpiSysTask;
       tf_data.tfname    = "$error";
       tf_data.calltf    = sys_severity_calltf;
-      tf_data.compiletf = sys_display_compiletf;
+      tf_data.compiletf = sys_severity_compiletf;
       tf_data.sizetf    = 0;
       tf_data.user_data = "$error";
       res = vpi_register_systf(&tf_data);
@@ -2342,7 +2523,7 @@ void sys_display_register()
       tf_data.type      = vpiSysTask;
       tf_data.tfname    = "$warning";
       tf_data.calltf    = sys_severity_calltf;
-      tf_data.compiletf = sys_display_compiletf;
+      tf_data.compiletf = sys_severity_compiletf;
       tf_data.sizetf    = 0;
       tf_data.user_data = "$warning";
       res = vpi_register_systf(&tf_data);
@@ -2351,7 +2532,7 @@ void sys_display_register()
       tf_data.type      = vpiSysTask;
       tf_data.tfname    = "$info";
       tf_data.calltf    = sys_severity_calltf;
-      tf_data.compiletf = sys_display_compiletf;
+      tf_data.compiletf = sys_severity_compiletf;
       tf_data.sizetf    = 0;
       tf_data.user_data = "$info";
       res = vpi_register_systf(&tf_data);
@@ -62,6 +62,12 @@ static enum lxm_optimum_mode_e {
       LXM_BOTH = 3
 } lxm_optimum_mode = LXM_NONE;
 
+  /* The compression level and number of compression threads for the
+   * value change blocks. A level of -1 uses the writer default, and 0
+   * workers writes the blocks in the simulation thread. */
+static int fst_compress_level = -1;
+static int fst_compress_workers = 1;
+
 static const char*units_names[] = {
       "s",
       "ms",
@@ -403,6 +409,10 @@ static void open_dumpfile(vpiHandle callh)
 	        (lxm_optimum_mode == LXM_BOTH)) {
 		  fstWriterSetRepackOnClose(dump_file, 1);
 	    }
+	    if (fst_compress_level >= 0) {
+		  fstWriterSetCompressionLevel(dump_file, fst_compress_level);
+	    }
+	    fstWriterSetCompressionWorkers(dump_file, fst_compress_workers);
       }
 }
 
@@ -860,6 +870,22 @@ void sys_fst_register()
 		  lxm_optimum_mode = LXM_BOTH;
 	    } else if (strcmp(vlog_info.argv[idx],"-fst-speed-space") == 0) {
 		  lxm_optimum_mode = LXM_BOTH;
+
+	    } else if (strncmp(vlog_info.argv[idx],"-fst-level=",11) == 0) {
+		  fst_compress_level = atoi(vlog_info.argv[idx]+11);
+		  if ((fst_compress_level < 0) || (fst_compress_level > 9)) {
+			vpi_printf("FST warning: compression level must be "
+			           "0 to 9, using the default.\n");
+			fst_compress_level = -1;
+		  }
+
+	    } else if (strncmp(vlog_info.argv[idx],"-fst-workers=",13) == 0) {
+		  fst_compress_workers = atoi(vlog_info.argv[idx]+13);
+		  if (fst_compress_workers < 0) {
+			vpi_printf("FST warning: the number of compression "
+			           "workers must not be negative.\n");
+			fst_compress_workers = 1;
+		  }
 	    }
       }
 
@@ -30,6 +30,13 @@
 char **search_list = NULL;
 unsigned sl_count = 0;
 
+/*
+ * The words are moved to and from the memory in runs of consecutive
+ * addresses with the vpip_*_memory_words functions. This is the
+ * largest number of words in a run.
+ */
+#define MEM_RUN_WORDS 4096
+
 static void get_mem_params(vpiHandle argv, vpiHandle callh, const char *name,
                            char **fname, vpiHandle *mitem,
                            vpiHandle *start_item, vpiHandle *stop_item)
@@ -256,6 +263,28 @@ static PLI_INT32 sys_mem_compiletf(ICARUS_VPI_CONST PLI_BYTE8*name)
       return 0;
 }
 
+/*
+ * Write a run of words to the memory. If the memory can not take the
+ * whole run in bulk, then write the rest of the words one at a time.
+ */
+static void readmem_put_run(vpiHandle mitem, int addr, int addr_incr,
+                            unsigned count, s_vpi_vecval*run,
+                            unsigned nwords)
+{
+      unsigned idx = vpip_put_memory_words(mitem, addr, addr_incr,
+                                           count, run);
+      s_vpi_value value;
+
+      value.format = vpiVectorVal;
+      for ( ; idx < count ; idx += 1) {
+	    vpiHandle word_index;
+	    word_index = vpi_handle_by_index(mitem, addr + idx*addr_incr);
+	    assert(word_index);
+	    value.value.vector = run + idx*nwords;
+	    vpi_put_value(word_index, &value, 0, vpiNoDelay);
+      }
+}
+
 static PLI_INT32 sys_readmem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 {
       int code, wwid, addr;
@@ -281,6 +310,11 @@ static PLI_INT32 sys_readmem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       /* This is the number of words that we need from the memory. */
       unsigned word_count;
 
+      /* The run of words waiting to be written to the memory. */
+      s_vpi_vecval*run;
+      unsigned nwords, run_count;
+      int run_addr;
+
       /*======================================== Get parameters */
 
       get_mem_params(argv, callh, name,
@@ -326,6 +360,11 @@ static PLI_INT32 sys_readmem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       value.format = vpiVectorVal;
       value.value.vector = calloc((wwid+31)/32, sizeof(s_vpi_vecval));
 
+      nwords = (wwid+31)/32;
+      run = malloc(MEM_RUN_WORDS*nwords*sizeof(s_vpi_vecval));
+      run_count = 0;
+      run_addr = 0;
+
       /* Configure the readmem lexer */
       if (strcmp(name,"$readmemb") == 0)
 	  sys_readmem_start_file(file, 1, wwid, value.value.vector);
@@ -339,6 +378,11 @@ static PLI_INT32 sys_readmem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       while ((code = readmemlex()) != 0) {
 	  switch (code) {
 	  case MEM_ADDRESS:
+	      if (run_count > 0) {
+		  readmem_put_run(mitem, run_addr, addr_incr, run_count,
+		                  run, nwords);
+		  run_count = 0;
+	      }
 	      addr = value.value.vector->aval;
 	      if (addr < min_addr || addr > max_addr) {
 		  vpi_printf("ERROR: %s:%d: ", vpi_get_str(vpiFile, callh),
@@ -357,10 +401,15 @@ static PLI_INT32 sys_readmem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 
 	  case MEM_WORD:
 	      if (addr >= min_addr && addr <= max_addr) {
-		  vpiHandle word_index;
-		  word_index = vpi_handle_by_index(mitem, addr);
-		  assert(word_index);
-		  vpi_put_value(word_index, &value, 0, vpiNoDelay);
+		  if (run_count == 0) run_addr = addr;
+		  memcpy(run + run_count*nwords, value.value.vector,
+		         nwords*sizeof(s_vpi_vecval));
+		  run_count += 1;
+		  if (run_count == MEM_RUN_WORDS) {
+			readmem_put_run(mitem, run_addr, addr_incr,
+			                run_count, run, nwords);
+			run_count = 0;
+		  }
 
 		  if (word_count > 0) word_count -= 1;
 	      } else {
@@ -399,6 +448,10 @@ static PLI_INT32 sys_readmem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       }
 
  bailout:
+	/* Write the words that were read before any error. */
+      if (run_count > 0)
+	    readmem_put_run(mitem, run_addr, addr_incr, run_count, run, nwords);
+      free(run);
       free(value.value.vector);
       free(fname);
       fclose(file);
@@ -502,6 +555,55 @@ static PLI_INT32 sys_readmempath_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       return 0;
 }
 
+/*
+ * Format a memory word the way vpiBinStrVal or vpiHexStrVal would.
+ * A hex digit that is all x or z bits is an x or z. A digit with only
+ * some z bits is a Z, and with any x bits is an X.
+ */
+static void writemem_format(char*buf, const s_vpi_vecval*word,
+                            unsigned wid, int hex_flag)
+{
+      unsigned idx;
+
+      if (!hex_flag) {
+	    for (idx = 0 ;  idx < wid ;  idx += 1) {
+		  const s_vpi_vecval*cur = word + idx/32;
+		  unsigned code = ((cur->aval >> (idx%32)) & 1)
+		                | (((cur->bval >> (idx%32)) & 1) << 1);
+		  buf[wid-idx-1] = "01zx"[code];
+	    }
+	    buf[wid] = 0;
+	    return;
+      }
+
+      unsigned ndig = (wid+3)/4;
+      for (idx = 0 ;  idx < ndig ;  idx += 1) {
+	    const s_vpi_vecval*cur = word + idx/8;
+	    unsigned sh = (idx%8) * 4;
+	    unsigned nbits = (wid - idx*4 < 4) ? wid - idx*4 : 4;
+	    unsigned mask = (1U << nbits) - 1;
+	    unsigned aval = (cur->aval >> sh) & mask;
+	    unsigned bval = (cur->bval >> sh) & mask;
+	    unsigned xbits = aval & bval;
+	    unsigned zbits = ~aval & bval;
+	    char ch;
+
+	    if (zbits == 0xf || (nbits < 4 && zbits == mask))
+		  ch = 'z';
+	    else if (xbits == 0xf || (nbits < 4 && xbits == mask))
+		  ch = 'x';
+	    else if (xbits)
+		  ch = 'X';
+	    else if (zbits)
+		  ch = 'Z';
+	    else
+		  ch = "0123456789abcdef"[aval];
+
+	    buf[ndig-idx-1] = ch;
+      }
+      buf[ndig] = 0;
+}
+
 static PLI_INT32 sys_writemem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 {
       int addr;
@@ -518,6 +620,11 @@ static PLI_INT32 sys_writemem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       int start_addr, stop_addr, addr_incr;
       int min_addr, max_addr; // Not used in this routine.
 
+      int wwid;
+      unsigned nwords;
+      s_vpi_vecval*run;
+      char*text;
+
       /*======================================== Get parameters */
 
       get_mem_params(argv, callh, name,
@@ -547,20 +654,47 @@ static PLI_INT32 sys_writemem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       if (strcmp(name,"$writememb")==0) value.format = vpiBinStrVal;
       else value.format = vpiHexStrVal;
 
+      wwid = vpi_get(vpiSize, vpi_handle_by_index(mitem, start_addr));
+      nwords = (wwid+31)/32;
+      run = malloc(MEM_RUN_WORDS*nwords*sizeof(s_vpi_vecval));
+      text = malloc(wwid+1);
+
       /*======================================== Write memory file */
 
       cnt = 0;
-      for(addr=start_addr; addr!=stop_addr+addr_incr; addr+=addr_incr, ++cnt) {
-	  vpiHandle word_index;
-
-	  if (cnt%16 == 0) fprintf(file, "// 0x%08x\n", cnt);
-
-	  word_index = vpi_handle_by_index(mitem, addr);
-	  assert(word_index);
-	  vpi_get_value(word_index, &value);
-	  fprintf(file, "%s\n", value.value.str);
+      addr = start_addr;
+      while (addr != stop_addr+addr_incr) {
+	  unsigned idx, run_count, run_words;
+
+	    /* Get a run of words, up to the end of the range. */
+	  run_count = (stop_addr - addr)*addr_incr + 1;
+	  if (run_count > MEM_RUN_WORDS) run_count = MEM_RUN_WORDS;
+	  run_words = vpip_get_memory_words(mitem, addr, addr_incr,
+	                                    run_count, run);
+
+	  for (idx = 0 ;  idx < run_count ;  idx += 1) {
+		if (cnt%16 == 0) fprintf(file, "// 0x%08x\n", cnt);
+
+		if (idx < run_words) {
+		      writemem_format(text, run + idx*nwords, wwid,
+		                      value.format == vpiHexStrVal);
+		      fputs(text, file);
+		      fputc('\n', file);
+		} else {
+		      vpiHandle word_index;
+		      word_index = vpi_handle_by_index(mitem, addr);
+		      assert(word_index);
+		      vpi_get_value(word_index, &value);
+		      fprintf(file, "%s\n", value.value.str);
+		}
+
+		addr += addr_incr;
+		cnt += 1;
+	  }
       }
 
+      free(text);
+      free(run);
       fclose(file);
       free(fname);
       return 0;
@@ -31,6 +31,9 @@
 # include  <time.h>
 # include  "ivl_alloc.h"
 
+/* The size of the stdio buffer for the dump file. */
+# define VCD_FILE_BUFFER (1024*1024)
+
 static char *dump_path = NULL;
 static FILE *dump_file = NULL;
 
@@ -39,14 +42,13 @@ struct vcd_info {
       vpiHandle cb;
       struct t_vpi_time time;
       const char *ident;
+      PLI_INT32 type;
+      unsigned size;
       struct vcd_info *next;
-      struct vcd_info *dmp_next;
-      int scheduled;
 };
 
 
 static struct vcd_info *vcd_list = NULL;
-static struct vcd_info *vcd_dmp_list = NULL;
 static PLI_UINT64 vcd_cur_time = 0;
 static int dump_is_off = 0;
 static long dump_limit = 0;
@@ -98,40 +100,84 @@ static char *truncate_bitvec(char *s)
       }
 }
 
+/*
+ * The value changes are formatted directly from the vpiVectorVal words
+ * into this buffer and written with a single fwrite. This avoids the
+ * string conversion that vpiBinStrVal does for every change and the
+ * format parsing of fprintf.
+ */
+static char *vcd_buf = 0;
+static size_t vcd_buf_size = 0;
+
+static char *vcd_buf_need(size_t size)
+{
+      if (size > vcd_buf_size) {
+	    vcd_buf = realloc(vcd_buf, size);
+	    vcd_buf_size = size;
+      }
+      return vcd_buf;
+}
+
+static const char vcd_bit_chars[4] = { '0', '1', 'z', 'x' };
+
 static void show_this_item(struct vcd_info*info)
 {
       s_vpi_value value;
-      PLI_INT32 type = vpi_get(vpiType, info->item);
 
-      if (type == vpiRealVar) {
+      if (info->type == vpiRealVar) {
 	    value.format = vpiRealVal;
 	    vpi_get_value(info->item, &value);
 	    fprintf(dump_file, "r%.16g %s\n", value.value.real, info->ident);
-      } else if (type == vpiNamedEvent) {
-	    fprintf(dump_file, "1%s\n", info->ident);
-      } else if (vpi_get(vpiSize, info->item) == 1) {
-	    value.format = vpiBinStrVal;
-	    vpi_get_value(info->item, &value);
-	    fprintf(dump_file, "%s%s\n", value.value.str, info->ident);
+      } else if (info->type == vpiNamedEvent) {
+	    fputc('1', dump_file);
+	    fputs(info->ident, dump_file);
+	    fputc('\n', dump_file);
       } else {
-	    value.format = vpiBinStrVal;
+	    size_t len = strlen(info->ident);
+	    unsigned wid = info->size;
+	    unsigned idx;
+	    char *buf, *cp, *start;
+
+	    value.format = vpiVectorVal;
 	    vpi_get_value(info->item, &value);
-	    fprintf(dump_file, "b%s %s\n", truncate_bitvec(value.value.str),
-		    info->ident);
+
+	      /* Room for the "b", the bits, the " ", the ident and
+	       * the trailing new line. */
+	    buf = vcd_buf_need(wid + len + 3);
+	    cp = buf + 1;
+	    for (idx = wid ;  idx > 0 ;  idx -= 1) {
+		  s_vpi_vecval *vv = value.value.vector + (idx-1)/32;
+		  unsigned bit = (idx-1) % 32;
+		  unsigned code = ((vv->aval >> bit) & 1)
+		                | (((vv->bval >> bit) & 1) << 1);
+		  *cp++ = vcd_bit_chars[code];
+	    }
+	    *cp = 0;
+
+	    if (wid == 1) {
+		  start = buf + 1;
+	    } else {
+		  start = truncate_bitvec(buf + 1);
+		  start -= 1;
+		  *start = 'b';
+		  *cp++ = ' ';
+	    }
+	    memcpy(cp, info->ident, len);
+	    cp += len;
+	    *cp++ = '\n';
+	    fwrite(start, 1, cp - start, dump_file);
       }
 }
 
 /* Dump values for a $dumpoff. */
 static void show_this_item_x(struct vcd_info*info)
 {
-      PLI_INT32 type = vpi_get(vpiType, info->item);
-
-      if (type == vpiRealVar) {
+      if (info->type == vpiRealVar) {
 	      /* Some tools dump nothing here...? */
 	    fprintf(dump_file, "rNaN %s\n", info->ident);
-      } else if (type == vpiNamedEvent) {
+      } else if (info->type == vpiNamedEvent) {
 	    /* Do nothing for named events. */
-      } else if (vpi_get(vpiSize, info->item) == 1) {
+      } else if (info->size == 1) {
 	    fprintf(dump_file, "x%s\n", info->ident);
       } else {
 	    fprintf(dump_file, "bx %s\n", info->ident);
@@ -174,35 +220,19 @@ static void vcd_checkpoint_x()
 	    show_this_item_x(cur);
 }
 
-static PLI_INT32 variable_cb_2(p_cb_data cause)
-{
-      struct vcd_info* info = vcd_dmp_list;
-      PLI_UINT64 now = timerec_to_time64(cause->time);
-
-      if (now != vcd_cur_time) {
-	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", now);
-	    vcd_cur_time = now;
-      }
-
-      do {
-           show_this_item(info);
-           info->scheduled = 0;
-      } while ((info = info->dmp_next) != 0);
-
-      vcd_dmp_list = 0;
-
-      return 0;
-}
-
-static PLI_INT32 variable_cb_1(p_cb_data cause)
+/*
+ * The value changes of the dumped variables are delivered by the
+ * run time as one batch per time step, in the read-only synch
+ * region. Each entry carries the vcd_info of a changed variable.
+ */
+static PLI_INT32 variable_cb(p_cb_data cause)
 {
-      struct t_cb_data cb;
-      struct vcd_info*info = (struct vcd_info*)cause->user_data;
+      PLI_INT32 idx, count = cause->index;
+      PLI_UINT64 now;
 
       if (dump_is_full) return 0;
       if (dump_is_off) return 0;
       if (dump_header_pending()) return 0;
-      if (info->scheduled) return 0;
 
       if ((dump_limit > 0) && (ftell(dump_file) > dump_limit)) {
             dump_is_full = 1;
@@ -213,16 +243,14 @@ static PLI_INT32 variable_cb_1(p_cb_data cause)
             return 0;
       }
 
-      if (!vcd_dmp_list) {
-          cb = *cause;
-          cb.reason = cbReadOnlySynch;
-          cb.cb_rtn = variable_cb_2;
-          vpi_register_cb(&cb);
+      now = timerec_to_time64(cause->time);
+      if (now != vcd_cur_time) {
+	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", now);
+	    vcd_cur_time = now;
       }
 
-      info->scheduled = 1;
-      info->dmp_next  = vcd_dmp_list;
-      vcd_dmp_list    = info;
+      for (idx = 0 ;  idx < count ;  idx += 1)
+	    show_this_item((struct vcd_info*)cause[idx].user_data);
 
       return 0;
 }
@@ -270,6 +298,9 @@ static PLI_INT32 finish_cb(p_cb_data cause)
 	    free(cur);
       }
       vcd_list = 0;
+      free(vcd_buf);
+      vcd_buf = 0;
+      vcd_buf_size = 0;
       vcd_names_delete(&vcd_tab);
       vcd_names_delete(&vcd_var);
       nexus_ident_delete();
@@ -413,6 +444,10 @@ static void open_dumpfile(vpiHandle callh)
 	    vpi_printf("VCD info: dumpfile %s opened for output.\n",
 	               dump_path);
 
+	      /* The value changes are many small writes, so give the
+	       * file a large buffer. */
+	    setvbuf(dump_file, 0, _IOFBF, VCD_FILE_BUFFER);
+
 	    time(&walltime);
 
 	    assert(prec >= -15);
@@ -636,16 +671,17 @@ static void scan_item(unsigned depth, vpiHandle item, int skip)
 		  info->time.type = vpiSimTime;
 		  info->item  = item;
 		  info->ident = ident;
-		  info->scheduled = 0;
+		  info->type  = item_type;
+		  info->size  = (item_type == vpiNamedEvent) ? 1 :
+		                vpi_get(vpiSize, item);
 
 		  cb.time      = &info->time;
 		  cb.user_data = (char*)info;
 		  cb.value     = NULL;
 		  cb.obj       = item;
-		  cb.reason    = cbValueChange;
-		  cb.cb_rtn    = variable_cb_1;
+		  cb.reason    = _cbValueChangeBatch;
+		  cb.cb_rtn    = variable_cb;
 
-		  info->dmp_next = 0;
 		  info->next  = vcd_list;
 		  vcd_list    = info;
 
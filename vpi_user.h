@@ -460,6 +460,18 @@ typedef struct t_cb_data {
 #define cbExitInteractive   22
 #define cbInteractiveScopeChange 23
 #define cbUnresolvedSystf   24
+/* IVL private callback reasons */
+/*
+ * A _cbValueChangeBatch callback is registered on an object just like
+ * a cbValueChange callback, but the cb_rtn is not called when the
+ * value changes. Instead the changed objects are collected, and once
+ * per time step in the read-only synch region cb_rtn is called a
+ * single time with a pointer to an array of t_cb_data, one for each
+ * changed object that uses that cb_rtn. The index member of each
+ * entry holds the number of entries in the array. The values are read
+ * at the time of delivery, and stay valid until cb_rtn returns.
+ */
+#define _cbValueChangeBatch 0x1000000
 
 extern vpiHandle vpi_register_cb(p_cb_data data);
 extern PLI_INT32 vpi_remove_cb(vpiHandle ref);
@@ -599,6 +611,37 @@ extern void vpip_set_return_value(int value);
 extern s_vpi_vecval vpip_calc_clog2(vpiHandle arg);
 extern void vpip_make_systf_system_defined(vpiHandle ref);
 
+  /* Copy count words to or from the memory (vpiMemory) mem, starting
+     at the word address addr and stepping the address by incr. Each
+     word uses (width+31)/32 entries of the buf array. These return
+     the number of words copied, which is short if an address is out
+     of range, or 0 if the memory does not hold vector values. */
+extern PLI_INT32 vpip_put_memory_words(vpiHandle mem, PLI_INT32 addr,
+				       PLI_INT32 incr, PLI_INT32 count,
+				       const s_vpi_vecval*buf);
+extern PLI_INT32 vpip_get_memory_words(vpiHandle mem, PLI_INT32 addr,
+				       PLI_INT32 incr, PLI_INT32 count,
+				       s_vpi_vecval*buf);
+
+  /* A read-only view of the value of a vector signal. The value is
+     split into abits and bbits words of word_bits bits each, least
+     significant word first, and encoded like s_vpi_vecval. The
+     pointers are only good until the value next changes, which is
+     when the change_count goes up. */
+typedef struct t_vpip_vector_ref {
+      PLI_INT32 size;
+      PLI_INT32 word_bits;
+      const unsigned long*abits;
+      const unsigned long*bbits;
+      unsigned long change_count;
+} s_vpip_vector_ref, *p_vpip_vector_ref;
+
+  /* Fill in the view of the value of the signal ref, without copying
+     or formatting it. This returns 0 if the value of the signal is
+     not kept as a single 4-value vector (e.g. real or strength
+     values, or some bits are forced), and 1 otherwise. */
+extern PLI_INT32 vpip_get_vector_ref(vpiHandle ref, s_vpip_vector_ref*vr);
+
 EXTERN_C_END
 
 #endif
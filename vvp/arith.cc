@@ -25,6 +25,49 @@
 # include  <cstdlib>
 # include  <cmath>
 
+/*
+ * The sum, difference and compare functors work on their operands a
+ * word at a time. This gets up to a word of bits from the operand
+ * starting at the address adr, and fills in any bits past the end of
+ * the operand with the pad bits (all 0s or all 1s).
+ */
+static const unsigned ARITH_WORD_BITS = 8*sizeof(unsigned long);
+
+static inline void arith_get_word(const vvp_vector4_t&vec,
+				  unsigned adr, unsigned wid,
+				  unsigned long pad,
+				  unsigned long&abits, unsigned long&bbits)
+{
+      if (adr >= vec.size()) {
+	    abits = pad;
+	    bbits = 0;
+	    return;
+      }
+
+      unsigned trans = wid;
+      if (adr+trans > vec.size())
+	    trans = vec.size() - adr;
+
+      vec.get_word(adr, trans, abits, bbits);
+      if (trans < wid)
+	    abits |= pad << trans;
+}
+
+static inline unsigned long add_with_carry(unsigned long a, unsigned long b,
+					   unsigned long&carry)
+{
+      unsigned long tmp = b + carry;
+      unsigned long sum = a + tmp;
+      carry = 0;
+      if (tmp < b)
+	    carry = 1;
+      if (sum < tmp)
+	    carry = 1;
+      if (sum < a)
+	    carry = 1;
+      return sum;
+}
+
 vvp_arith_::vvp_arith_(unsigned wid)
 : wid_(wid), x_val_(wid)
 {
@@ -246,14 +289,7 @@ void vvp_arith_div::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       assert(wid_ <= 8*sizeof(val));
 
       vvp_vector4_t vval (wid_);
-      for (unsigned idx = 0 ;  idx < wid_ ;  idx += 1) {
-	    if (val & 1)
-		  vval.set_bit(idx, BIT4_1);
-	    else
-		  vval.set_bit(idx, BIT4_0);
-
-	    val >>= 1;
-      }
+      vval.set_word(0, wid_, val, 0);
 
       ptr.ptr()->send_vec4(vval, 0);
 }
@@ -358,14 +394,7 @@ void vvp_arith_mod::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       assert(wid_ <= 8*sizeof(val));
 
       vvp_vector4_t vval (wid_);
-      for (unsigned idx = 0 ;  idx < wid_ ;  idx += 1) {
-	    if (val & 1)
-		  vval.set_bit(idx, BIT4_1);
-	    else
-		  vval.set_bit(idx, BIT4_0);
-
-	    val >>= 1;
-      }
+      vval.set_word(0, wid_, val, 0);
 
       ptr.ptr()->send_vec4(vval, 0);
 }
@@ -424,14 +453,7 @@ void vvp_arith_mult::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       assert(wid_ <= 8*sizeof(val));
 
       vvp_vector4_t vval (wid_);
-      for (unsigned idx = 0 ;  idx < wid_ ;  idx += 1) {
-	    if (val & 1)
-		  vval.set_bit(idx, BIT4_1);
-	    else
-		  vval.set_bit(idx, BIT4_0);
-
-	    val >>= 1;
-      }
+      vval.set_word(0, wid_, (unsigned long) val, 0);
 
       ptr.ptr()->send_vec4(vval, 0);
 }
@@ -502,22 +524,24 @@ void vvp_arith_sum::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 
       vvp_vector4_t value (wid_);
 
-	/* Pad input vectors with this value to widen to the desired
-	   output width. */
-      const vvp_bit4_t pad = BIT4_0;
-
-      vvp_bit4_t carry = BIT4_0;
-      for (unsigned idx = 0 ;  idx < wid_ ;  idx += 1) {
-	    vvp_bit4_t a = (idx >= op_a_.size())? pad : op_a_.value(idx);
-	    vvp_bit4_t b = (idx >= op_b_.size())? pad : op_b_.value(idx);
-	    vvp_bit4_t cur = add_with_carry(a, b, carry);
-
-	    if (cur == BIT4_X) {
+	/* Input vectors narrower than the output are padded with 0
+	   bits. An X or Z bit anywhere in the inputs makes the entire
+	   result X, so there is no need to go any further. */
+      unsigned long carry = 0;
+      for (unsigned idx = 0 ;  idx < wid_ ;  idx += ARITH_WORD_BITS) {
+	    unsigned trans = wid_ - idx;
+	    if (trans > ARITH_WORD_BITS)
+		  trans = ARITH_WORD_BITS;
+
+	    unsigned long aa, ab, ba, bb;
+	    arith_get_word(op_a_, idx, trans, 0UL, aa, ab);
+	    arith_get_word(op_b_, idx, trans, 0UL, ba, bb);
+	    if (ab | bb) {
 		  net->send_vec4(x_val_, 0);
 		  return;
 	    }
 
-	    value.set_bit(idx, cur);
+	    value.set_word(idx, trans, add_with_carry(aa, ba, carry), 0);
       }
 
       net->send_vec4(value, 0);
@@ -547,22 +571,23 @@ void vvp_arith_sub::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 
       vvp_vector4_t value (wid_);
 
-	/* Pad input vectors with this value to widen to the desired
-	   output width. */
-      const vvp_bit4_t pad = BIT4_1;
-
-      vvp_bit4_t carry = BIT4_1;
-      for (unsigned idx = 0 ;  idx < wid_ ;  idx += 1) {
-	    vvp_bit4_t a = (idx >= op_a_.size())? pad : op_a_.value(idx);
-	    vvp_bit4_t b = (idx >= op_b_.size())? pad : ~op_b_.value(idx);
-	    vvp_bit4_t cur = add_with_carry(a, b, carry);
-
-	    if (cur == BIT4_X) {
+	/* The A input is padded with 1 bits and the inverted B input
+	   is padded with 1 bits to widen to the desired output width. */
+      unsigned long carry = 1;
+      for (unsigned idx = 0 ;  idx < wid_ ;  idx += ARITH_WORD_BITS) {
+	    unsigned trans = wid_ - idx;
+	    if (trans > ARITH_WORD_BITS)
+		  trans = ARITH_WORD_BITS;
+
+	    unsigned long aa, ab, ba, bb;
+	    arith_get_word(op_a_, idx, trans, ~0UL, aa, ab);
+	    arith_get_word(op_b_, idx, trans, 0UL, ba, bb);
+	    if (ab | bb) {
 		  net->send_vec4(x_val_, 0);
 		  return;
 	    }
 
-	    value.set_bit(idx, cur);
+	    value.set_word(idx, trans, add_with_carry(aa, ~ba, carry), 0);
       }
 
       net->send_vec4(value, 0);
@@ -582,12 +607,19 @@ void vvp_cmp_eeq::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       eeq.set_bit(0, BIT4_1);
 
       assert(op_a_.size() == op_b_.size());
-      for (unsigned idx = 0 ;  idx < op_a_.size() ;  idx += 1)
-	    if (op_a_.value(idx) != op_b_.value(idx)) {
+      for (unsigned idx = 0 ;  idx < op_a_.size() ;  idx += ARITH_WORD_BITS) {
+	    unsigned trans = op_a_.size() - idx;
+	    if (trans > ARITH_WORD_BITS)
+		  trans = ARITH_WORD_BITS;
+
+	    unsigned long aa, ab, ba, bb;
+	    op_a_.get_word(idx, trans, aa, ab);
+	    op_b_.get_word(idx, trans, ba, bb);
+	    if ((aa ^ ba) | (ab ^ bb)) {
 		  eeq.set_bit(0, BIT4_0);
 		  break;
 	    }
-
+      }
 
       vvp_net_t*net = ptr.ptr();
       net->send_vec4(eeq, 0);
@@ -607,12 +639,19 @@ void vvp_cmp_nee::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       eeq.set_bit(0, BIT4_0);
 
       assert(op_a_.size() == op_b_.size());
-      for (unsigned idx = 0 ;  idx < op_a_.size() ;  idx += 1)
-	    if (op_a_.value(idx) != op_b_.value(idx)) {
+      for (unsigned idx = 0 ;  idx < op_a_.size() ;  idx += ARITH_WORD_BITS) {
+	    unsigned trans = op_a_.size() - idx;
+	    if (trans > ARITH_WORD_BITS)
+		  trans = ARITH_WORD_BITS;
+
+	    unsigned long aa, ab, ba, bb;
+	    op_a_.get_word(idx, trans, aa, ab);
+	    op_b_.get_word(idx, trans, ba, bb);
+	    if ((aa ^ ba) | (ab ^ bb)) {
 		  eeq.set_bit(0, BIT4_1);
 		  break;
 	    }
-
+      }
 
       vvp_net_t*net = ptr.ptr();
       net->send_vec4(eeq, 0);
@@ -643,22 +682,22 @@ void vvp_cmp_eq::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       vvp_vector4_t res (1);
       res.set_bit(0, BIT4_1);
 
-      for (unsigned idx = 0 ;  idx < op_a_.size() ;  idx += 1) {
-	    vvp_bit4_t a = op_a_.value(idx);
-	    vvp_bit4_t b = op_b_.value(idx);
+      for (unsigned idx = 0 ;  idx < op_a_.size() ;  idx += ARITH_WORD_BITS) {
+	    unsigned trans = op_a_.size() - idx;
+	    if (trans > ARITH_WORD_BITS)
+		  trans = ARITH_WORD_BITS;
 
-	    if (a == BIT4_X)
-		  res.set_bit(0, BIT4_X);
-	    else if (a == BIT4_Z)
-		  res.set_bit(0, BIT4_X);
-	    else if (b == BIT4_X)
-		  res.set_bit(0, BIT4_X);
-	    else if (b == BIT4_Z)
-		  res.set_bit(0, BIT4_X);
-            else if (a != b) {
+	    unsigned long aa, ab, ba, bb;
+	    op_a_.get_word(idx, trans, aa, ab);
+	    op_b_.get_word(idx, trans, ba, bb);
+
+	    unsigned long xz = ab | bb;
+	    if ((aa ^ ba) & ~xz) {
 		  res.set_bit(0, BIT4_0);
 		  break;
 	    }
+	    if (xz)
+		  res.set_bit(0, BIT4_X);
       }
 
       vvp_net_t*net = ptr.ptr();
@@ -691,22 +730,22 @@ void vvp_cmp_ne::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       vvp_vector4_t res (1);
       res.set_bit(0, BIT4_0);
 
-      for (unsigned idx = 0 ;  idx < op_a_.size() ;  idx += 1) {
-	    vvp_bit4_t a = op_a_.value(idx);
-	    vvp_bit4_t b = op_b_.value(idx);
+      for (unsigned idx = 0 ;  idx < op_a_.size() ;  idx += ARITH_WORD_BITS) {
+	    unsigned trans = op_a_.size() - idx;
+	    if (trans > ARITH_WORD_BITS)
+		  trans = ARITH_WORD_BITS;
 
-	    if (a == BIT4_X)
-		  res.set_bit(0, BIT4_X);
-	    else if (a == BIT4_Z)
-		  res.set_bit(0, BIT4_X);
-	    else if (b == BIT4_X)
-		  res.set_bit(0, BIT4_X);
-	    else if (b == BIT4_Z)
-		  res.set_bit(0, BIT4_X);
-            else if (a != b) {
+	    unsigned long aa, ab, ba, bb;
+	    op_a_.get_word(idx, trans, aa, ab);
+	    op_b_.get_word(idx, trans, ba, bb);
+
+	    unsigned long xz = ab | bb;
+	    if ((aa ^ ba) & ~xz) {
 		  res.set_bit(0, BIT4_1);
 		  break;
 	    }
+	    if (xz)
+		  res.set_bit(0, BIT4_X);
       }
 
       vvp_net_t*net = ptr.ptr();
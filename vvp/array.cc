@@ -966,6 +966,83 @@ double array_get_word_r(vvp_array_t arr, unsigned address)
 
 }
 
+/*
+ * These are the bulk access functions that the $readmem and $writemem
+ * tasks use to move many words at once. They skip the word handles
+ * and the generic vpi_put_value/vpi_get_value processing, and move
+ * the words 32 bits at a time. The s_vpi_vecval and vvp_vector4_t
+ * encodings of the 4 bit values are the same.
+ */
+extern "C" PLI_INT32 vpip_put_memory_words(vpiHandle ref, PLI_INT32 addr,
+					   PLI_INT32 incr, PLI_INT32 count,
+					   const s_vpi_vecval*buf)
+{
+      if (ref->vpi_type->type_code != vpiMemory)
+	    return 0;
+
+      struct __vpiArray*arr = ARRAY_HANDLE(ref);
+      if (vpi_array_is_real(arr))
+	    return 0;
+
+      unsigned width = get_array_word_size(arr);
+      unsigned nwords = (width + 31) / 32;
+      vvp_vector4_t tmp (width);
+
+      PLI_INT32 cnt;
+      for (cnt = 0 ;  cnt < count ;  cnt += 1, addr += incr) {
+	    long index = (long)addr - arr->first_addr.value;
+	    if (index < 0 || index >= (long)arr->array_count)
+		  break;
+
+	    for (unsigned idx = 0 ;  idx < nwords ;  idx += 1) {
+		  unsigned off = idx * 32;
+		  unsigned wid = (width - off < 32)? width - off : 32;
+		  tmp.set_word(off, wid, (PLI_UINT32) buf->aval,
+			       (PLI_UINT32) buf->bval);
+		  buf += 1;
+	    }
+
+	    array_set_word(arr, index, 0, tmp);
+      }
+
+      return cnt;
+}
+
+extern "C" PLI_INT32 vpip_get_memory_words(vpiHandle ref, PLI_INT32 addr,
+					   PLI_INT32 incr, PLI_INT32 count,
+					   s_vpi_vecval*buf)
+{
+      if (ref->vpi_type->type_code != vpiMemory)
+	    return 0;
+
+      struct __vpiArray*arr = ARRAY_HANDLE(ref);
+      if (vpi_array_is_real(arr))
+	    return 0;
+
+      unsigned width = get_array_word_size(arr);
+      unsigned nwords = (width + 31) / 32;
+
+      PLI_INT32 cnt;
+      for (cnt = 0 ;  cnt < count ;  cnt += 1, addr += incr) {
+	    long index = (long)addr - arr->first_addr.value;
+	    if (index < 0 || index >= (long)arr->array_count)
+		  break;
+
+	    vvp_vector4_t tmp = array_get_word(arr, index);
+	    for (unsigned idx = 0 ;  idx < nwords ;  idx += 1) {
+		  unsigned off = idx * 32;
+		  unsigned wid = (width - off < 32)? width - off : 32;
+		  unsigned long abits, bbits;
+		  tmp.get_word(off, wid, abits, bbits);
+		  buf->aval = abits;
+		  buf->bval = bbits;
+		  buf += 1;
+	    }
+      }
+
+      return cnt;
+}
+
 static vpiHandle vpip_make_array(char*label, const char*name,
 				 int first_addr, int last_addr,
 				 bool signed_flag)
@@ -96,6 +96,28 @@ vvp_code_t codespace_null(void)
       return first_chunk + 0;
 }
 
+void codespace_fuse(void)
+{
+      for (vvp_code_t chunk = first_chunk ; chunk ; ) {
+	    vvp_code_t next = chunk[code_chunk_size-1].cptr;
+	      /* The last chunk is only filled up to the next free
+		 instruction. The others end with the link opcode. */
+	    unsigned fill = next? code_chunk_size-1 : current_within_chunk;
+
+	    for (unsigned idx = 0 ;  idx < fill ;  idx += 1) {
+		  vvp_code_fun fused = vthread_fused_opcode(chunk+idx,
+							    fill-idx);
+		  if (fused == 0)
+			continue;
+
+		  chunk[idx].opcode = fused;
+		  count_opcodes_fused += 1;
+	    }
+
+	    chunk = next;
+      }
+}
+
 #ifdef CHECK_WITH_VALGRIND
 void codespace_delete(void)
 {
@@ -174,6 +174,13 @@ extern bool of_EXEC_UFUNC(vthread_t thr, vvp_code_t code);
 
 extern bool of_CHUNK_LINK(vthread_t thr, vvp_code_t code);
 
+/*
+ * If the avail instructions starting at cp begin with a sequence that
+ * has a superinstruction, return the superinstruction. Otherwise,
+ * return nil. This is also implemented in vthread.cc.
+ */
+extern vvp_code_fun vthread_fused_opcode(vvp_code_t cp, unsigned avail);
+
 /*
  * This is the format of a machine code instruction.
  */
@@ -215,4 +222,18 @@ extern vvp_code_t codespace_allocate(void);
 extern vvp_code_t codespace_next(void);
 extern vvp_code_t codespace_null(void);
 
+/*
+ * This function scans the code space after all the code labels are
+ * resolved, and replaces common instruction sequences with
+ * superinstructions.
+ */
+extern void codespace_fuse(void);
+
+/*
+ * Return the assembly mnemonic for the opcode function, or nil if the
+ * function is not in the opcode table. The profile report uses this
+ * to name the opcodes that it counts.
+ */
+extern const char* opcode_mnemonic(vvp_code_fun fun);
+
 #endif
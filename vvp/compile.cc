@@ -28,6 +28,7 @@
 # include  "vpi_priv.h"
 # include  "parse_misc.h"
 # include  "statistics.h"
+# include  "profile.h"
 # include  <iostream>
 # include  <list>
 # include  <cstdlib>
@@ -220,6 +221,16 @@ static int opcode_compare(const void*k, const void*r)
       return strcmp(kp, rp->mnemonic);
 }
 
+const char* opcode_mnemonic(vvp_code_fun fun)
+{
+      for (unsigned idx = 0 ;  idx < opcode_count ;  idx += 1) {
+	    if (opcode_table[idx].opcode == fun)
+		  return opcode_table[idx].mnemonic;
+      }
+
+      return 0;
+}
+
 /*
  * Keep a symbol table of addresses within code space. Labels on
  * executable opcodes are mapped to their address here.
@@ -262,6 +273,8 @@ void define_functor_symbol(const char*label, vvp_net_t*net)
       symbol_value_t val;
       val.net = net;
       sym_set_value(sym_functors, label, val);
+      if (profile_flag)
+	    profile_net(net);
 }
 
 static vvp_net_t*lookup_functor_symbol(const char*label)
@@ -657,6 +670,23 @@ void compile_cleanup(void)
 
       compile_errors += nerrs;
 
+	/* With all the code labels resolved, the instruction
+	   sequences are final and can be fused. Don't fuse if the
+	   execution is being profiled, so that the profile counts
+	   the opcodes that are in the source. */
+      if (nerrs == 0 && !profile_flag) {
+	    if (verbose_flag) {
+		  fprintf(stderr, " ... Fusing opcodes\n");
+		  fflush(stderr);
+	    }
+	    codespace_fuse();
+      }
+
+	/* The functors are all linked now, so the profile can put its
+	   counting functors in front of them. */
+      if (nerrs == 0 && profile_flag)
+	    profile_wrap_nets();
+
       if (verbose_flag) {
 	    fprintf(stderr, " ... Removing symbol tables\n");
 	    fflush(stderr);
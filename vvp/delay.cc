@@ -19,6 +19,7 @@
 
 #include "delay.h"
 #include "schedule.h"
+#include "statistics.h"
 #include "vpi_priv.h"
 #include "config.h"
 #ifdef CHECK_WITH_VALGRIND
@@ -159,7 +160,10 @@ vvp_fun_delay::vvp_fun_delay(vvp_net_t*n, unsigned width, const vvp_delay_t&d)
       } else {
             schedule_init_propagate(net_, cur_real_);
       }
-      list_ = 0;
+      ring_ = 0;
+      ring_mask_ = 0;
+      ring_head_ = 0;
+      ring_count_ = 0;
       type_ = UNKNOWN_DELAY;
       initial_ = true;
 	// Calculate the values used when converting variable delays
@@ -177,67 +181,93 @@ vvp_fun_delay::vvp_fun_delay(vvp_net_t*n, unsigned width, const vvp_delay_t&d)
 
 vvp_fun_delay::~vvp_fun_delay()
 {
-      while (struct event_*cur = dequeue_())
-	    delete cur;
+      delete[]ring_;
 }
 
-bool vvp_fun_delay::clean_pulse_events_(vvp_time64_t use_delay,
+/*
+ * Add an event to the end of the ring and return the slot so that the
+ * caller can fill in the value.
+ */
+struct vvp_fun_delay::event_* vvp_fun_delay::enqueue_(vvp_time64_t sim_time)
+{
+      if (ring_ == 0 || ring_count_ > ring_mask_)
+	    grow_ring_();
+
+      struct event_*cur = ring_ + ((ring_head_+ring_count_) & ring_mask_);
+      ring_count_ += 1;
+      cur->sim_time = sim_time;
+      count_delay_scheduled += 1;
+      return cur;
+}
+
+void vvp_fun_delay::grow_ring_(void)
+{
+      unsigned size = ring_? 2*(ring_mask_+1) : 2;
+      struct event_*tmp = new struct event_[size];
+
+      for (unsigned idx = 0 ;  idx < ring_count_ ;  idx += 1)
+	    tmp[idx] = ring_[(ring_head_+idx) & ring_mask_];
+
+      delete[]ring_;
+      ring_ = tmp;
+      ring_mask_ = size - 1;
+      ring_head_ = 0;
+}
+
+bool vvp_fun_delay::clean_pulse_events_(vvp_time64_t,
                                         const vvp_vector4_t&bit)
 {
-      if (list_ == 0) return false;
+      if (ring_count_ == 0) return false;
 
 	/* If the most recent event and the new event have the same
 	 * value then we need to skip the new event. */
-      if (list_->next->ptr_vec4.eeq(bit)) return true;
+      if (oldest_()->ptr_vec4.eeq(bit)) return true;
 
-      clean_pulse_events_(use_delay);
+      clean_pulse_events_();
       return false;
 }
 
-bool vvp_fun_delay::clean_pulse_events_(vvp_time64_t use_delay,
+bool vvp_fun_delay::clean_pulse_events_(vvp_time64_t,
                                         const vvp_vector8_t&bit)
 {
-      if (list_ == 0) return false;
+      if (ring_count_ == 0) return false;
 
 	/* If the most recent event and the new event have the same
 	 * value then we need to skip the new event. */
-      if (list_->next->ptr_vec8.eeq(bit)) return true;
+      if (oldest_()->ptr_vec8.eeq(bit)) return true;
 
-      clean_pulse_events_(use_delay);
+      clean_pulse_events_();
       return false;
 }
 
-bool vvp_fun_delay::clean_pulse_events_(vvp_time64_t use_delay,
+bool vvp_fun_delay::clean_pulse_events_(vvp_time64_t,
                                         double bit)
 {
-      if (list_ == 0) return false;
+      if (ring_count_ == 0) return false;
 
 	/* If the most recent event and the new event have the same
 	 * value then we need to skip the new event. */
-      if (list_->next->ptr_real == bit) return true;
+      if (oldest_()->ptr_real == bit) return true;
 
-      clean_pulse_events_(use_delay);
+      clean_pulse_events_();
       return false;
 }
 
-void vvp_fun_delay::clean_pulse_events_(vvp_time64_t use_delay)
+/*
+ * Cancel the pending events that have not matured yet. They are
+ * pulses that the new event replaces (inertial delay). The events are
+ * dropped by moving the head of the ring, and the scheduler entries
+ * for them find nothing to do when they run.
+ */
+void vvp_fun_delay::clean_pulse_events_(void)
 {
-      assert(list_ != 0);
-
-      do {
-	    struct event_*cur = list_->next;
-	      /* If this event is far enough from the event I'm about
-	         to create, then that scheduled event is not a pulse
-	         to be eliminated, so we're done. */
-	    if (cur->sim_time+use_delay <= use_delay+schedule_simtime())
-		  break;
-
-	    if (list_ == cur)
-		  list_ = 0;
-	    else
-		  list_->next = cur->next;
-	    delete cur;
-      } while (list_);
+      vvp_time64_t now = schedule_simtime();
+
+      while (ring_count_ > 0 && oldest_()->sim_time > now) {
+	    ring_head_ = (ring_head_+1) & ring_mask_;
+	    ring_count_ -= 1;
+	    count_delay_cancelled += 1;
+      }
 }
 
 /*
@@ -293,7 +323,7 @@ void vvp_fun_delay::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 	      // current value of the output. Detect and handle the
 	      // special case that the event list contains the current
 	      // value as a zero-delay-remaining event.
-	    const vvp_vector4_t&use_vec4 = (list_ && list_->next->sim_time == schedule_simtime())? list_->next->ptr_vec4 : cur_vec4_;
+	    const vvp_vector4_t&use_vec4 = (ring_count_ && oldest_()->sim_time == schedule_simtime())? oldest_()->ptr_vec4 : cur_vec4_;
 
 	      /* How many bits to compare? */
 	    unsigned use_wid = use_vec4.size();
@@ -318,15 +348,14 @@ void vvp_fun_delay::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
       vvp_time64_t use_simtime = schedule_simtime() + use_delay;
 
 	/* And propagate it. */
-      if (use_delay == 0 && list_ == 0) {
+      if (use_delay == 0 && ring_count_ == 0) {
 	    cur_vec4_ = bit;
 	    initial_ = false;
 	    net_->send_vec4(cur_vec4_, 0);
       } else {
-	    struct event_*cur = new struct event_(use_simtime);
+	    struct event_*cur = enqueue_(use_simtime);
 	    cur->run_run_ptr = &vvp_fun_delay::run_run_vec4_;
 	    cur->ptr_vec4 = bit;
-	    enqueue_(cur);
 	    schedule_generic(this, use_delay, false);
       }
 }
@@ -355,7 +384,7 @@ void vvp_fun_delay::recv_vec8(vvp_net_ptr_t port, const vvp_vector8_t&bit)
 	      // current value of the output. Detect and handle the
 	      // special case that the event list contains the current
 	      // value as a zero-delay-remaining event.
-	    const vvp_vector8_t&use_vec8 = (list_ && list_->next->sim_time == schedule_simtime())? list_->next->ptr_vec8 : cur_vec8_;
+	    const vvp_vector8_t&use_vec8 = (ring_count_ && oldest_()->sim_time == schedule_simtime())? oldest_()->ptr_vec8 : cur_vec8_;
 
 	      /* How many bits to compare? */
 	    unsigned use_wid = use_vec8.size();
@@ -382,15 +411,14 @@ void vvp_fun_delay::recv_vec8(vvp_net_ptr_t port, const vvp_vector8_t&bit)
       vvp_time64_t use_simtime = schedule_simtime() + use_delay;
 
 	/* And propagate it. */
-      if (use_delay == 0 && list_ == 0) {
+      if (use_delay == 0 && ring_count_ == 0) {
 	    cur_vec8_ = bit;
 	    initial_ = false;
 	    net_->send_vec8(cur_vec8_);
       } else {
-	    struct event_*cur = new struct event_(use_simtime);
+	    struct event_*cur = enqueue_(use_simtime);
 	    cur->ptr_vec8 = bit;
 	    cur->run_run_ptr = &vvp_fun_delay::run_run_vec8_;
-	    enqueue_(cur);
 	    schedule_generic(this, use_delay, false);
       }
 }
@@ -441,15 +469,14 @@ void vvp_fun_delay::recv_real(vvp_net_ptr_t port, double bit,
 
       vvp_time64_t use_simtime = schedule_simtime() + use_delay;
 
-      if (use_delay == 0 && list_ == 0) {
+      if (use_delay == 0 && ring_count_ == 0) {
 	    cur_real_ = bit;
 	    initial_ = false;
 	    net_->send_real(cur_real_, 0);
       } else {
-	    struct event_*cur = new struct event_(use_simtime);
+	    struct event_*cur = enqueue_(use_simtime);
 	    cur->run_run_ptr = &vvp_fun_delay::run_run_real_;
 	    cur->ptr_real = bit;
-	    enqueue_(cur);
 
 	    schedule_generic(this, use_delay, false);
       }
@@ -458,16 +485,19 @@ void vvp_fun_delay::recv_real(vvp_net_ptr_t port, double bit,
 void vvp_fun_delay::run_run()
 {
       vvp_time64_t sim_time = schedule_simtime();
-      if (list_ == 0 || list_->next->sim_time > sim_time)
+      if (ring_count_ == 0 || oldest_()->sim_time > sim_time)
 	    return;
 
-      struct event_*cur = dequeue_();
-      if (cur == 0)
-	    return;
+	/* Take the event off the ring before running it. The run
+	   functions copy the value out of the slot before they
+	   propagate it, so the slot may be reused by an event that
+	   the propagation schedules. */
+      struct event_*cur = oldest_();
+      ring_head_ = (ring_head_+1) & ring_mask_;
+      ring_count_ -= 1;
 
       (this->*(cur->run_run_ptr))(cur);
       initial_ = false;
-      delete cur;
 }
 
 void vvp_fun_delay::run_run_vec4_(struct event_*cur)
@@ -75,16 +75,12 @@ class vvp_fun_delay  : public vvp_net_fun_t, private vvp_gen_event_s {
 
       enum delay_type_t {UNKNOWN_DELAY, VEC4_DELAY, VEC8_DELAY, REAL_DELAY};
       struct event_ {
-	    event_(vvp_time64_t s) : sim_time(s) {
-		  ptr_real = 0.0;
-		  next = NULL;
-	    }
+	    event_() : sim_time(0), ptr_real(0.0) { }
 	    void (vvp_fun_delay::*run_run_ptr)(struct vvp_fun_delay::event_*cur);
-	    const vvp_time64_t sim_time;
+	    vvp_time64_t sim_time;
 	    vvp_vector4_t ptr_vec4;
 	    vvp_vector8_t ptr_vec8;
 	    double ptr_real;
-	    struct event_*next;
       };
 
     public:
@@ -117,34 +113,24 @@ class vvp_fun_delay  : public vvp_net_fun_t, private vvp_gen_event_s {
       double cur_real_;
       vvp_time64_t round_, scale_; // Needed to scale variable time values.
 
-      struct event_ *list_;
-      void enqueue_(struct event_*cur)
+	// The pending output events are kept in a ring of event
+	// slots, oldest first. The ring is allocated by the first
+	// event and grows by doubling, so after that scheduling and
+	// cancelling events only moves the head and count.
+      struct event_ *ring_;
+      unsigned ring_mask_;
+      unsigned ring_head_;
+      unsigned ring_count_;
+      struct event_* oldest_(void) const
       {
-	    if (list_) {
-		  cur->next = list_->next;
-		  list_->next = cur;
-		  list_ = cur;
-	    } else {
-		  cur->next = cur;
-		  list_ = cur;
-	    }
-      }
-      struct event_* dequeue_(void)
-      {
-	    if (list_ == 0)
-		  return 0;
-	    struct event_*cur = list_->next;
-	    if (list_ == cur)
-		  list_ = 0;
-	    else
-		  list_->next = cur->next;
-	    return cur;
+	    return ring_ + ring_head_;
       }
+      struct event_* enqueue_(vvp_time64_t sim_time);
+      void grow_ring_(void);
       bool clean_pulse_events_(vvp_time64_t use_delay, const vvp_vector4_t&bit);
       bool clean_pulse_events_(vvp_time64_t use_delay, const vvp_vector8_t&bit);
       bool clean_pulse_events_(vvp_time64_t use_delay, double bit);
-// Delete this when done!
-      void clean_pulse_events_(vvp_time64_t use_delay);
+      void clean_pulse_events_(void);
 };
 
 /*
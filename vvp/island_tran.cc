@@ -22,13 +22,66 @@
 # include  "symbols.h"
 # include  "schedule.h"
 # include  <list>
+# include  <vector>
+# include  <map>
+# include  <algorithm>
+# include  <climits>
 
 using namespace std;
 
+struct vvp_island_branch_tran;
+
+/*
+ * The branch ends that are connected together form a node. When the
+ * island first runs, it collects the ends of each node into a flat
+ * array, so that resolution can scan a node without building lists
+ * or casting the branches.
+ */
+struct tran_end_s {
+      vvp_island_branch_tran*ptr;
+      unsigned ab;
+};
+
+struct tran_node_s {
+      tran_end_s*ends;
+      unsigned count;
+};
+
 class vvp_island_tran : public vvp_island {
 
     public:
+      vvp_island_tran();
       void run_island();
+
+    private:
+      void build_tables_();
+      void mark_port_dirty_(const vvp_island_port*port);
+
+    private:
+      bool tables_done_;
+      vector<tran_end_s> ends_;
+      vector<tran_node_s> nodes_;
+
+	// The branches of the island are grouped into components that
+	// are connected through their A/B sides. The branches of
+	// component c are comp_branch_[comp_start_[c]] up to
+	// comp_branch_[comp_start_[c+1]], in island order. A change
+	// can only affect the components that it touches.
+      vector<unsigned> comp_start_;
+      vector<vvp_island_branch_tran*> comp_branch_;
+      vector<bool> comp_dirty_;
+      vector<unsigned> dirty_list_;
+
+	// The components that port p connects to, or enables, are
+	// port_comp_[port_start_[p]] up to port_comp_[port_start_[p+1]].
+      vector<unsigned> port_start_;
+      vector<unsigned> port_comp_;
+
+	// These are the enable ports that get their value from the
+	// island (see run_test_enabled) and the enable value that was
+	// last seen for each of them.
+      vector<vvp_island_port*> fb_port_;
+      vector<vvp_bit4_t> fb_value_;
 };
 
 struct vvp_island_branch_tran : public vvp_island_branch {
@@ -59,6 +112,13 @@ struct vvp_island_branch_tran : public vvp_island_branch {
       bool active_high;
       bool enabled_flag;
 
+	// The enable port, and the node and position within the node
+	// of each end of the branch. The island fills these in when
+	// it builds its tables.
+      vvp_island_port*en_port;
+      tran_node_s*node[2];
+      unsigned node_pos[2];
+
     private:
       int flags_;
 };
@@ -73,6 +133,11 @@ vvp_island_branch_tran::vvp_island_branch_tran(vvp_net_t*en__,
 {
       flags_ = 0;
       enabled_flag = en__ ? false : true;
+      en_port = 0;
+      node[0] = 0;
+      node[1] = 0;
+      node_pos[0] = 0;
+      node_pos[1] = 0;
 }
 
 static inline vvp_island_branch_tran* BRANCH_TRAN(vvp_island_branch*tmp)
@@ -82,31 +147,252 @@ static inline vvp_island_branch_tran* BRANCH_TRAN(vvp_island_branch*tmp)
       return res;
 }
 
+static inline vvp_island_port* ISLAND_PORT(vvp_net_t*net)
+{
+      vvp_island_port*res = dynamic_cast<vvp_island_port*>(net->fun);
+      assert(res);
+      return res;
+}
+
+static unsigned find_root(vector<unsigned>&parent, unsigned idx)
+{
+      while (parent[idx] != idx) {
+	    parent[idx] = parent[parent[idx]];
+	    idx = parent[idx];
+      }
+      return idx;
+}
+
+vvp_island_tran::vvp_island_tran()
+{
+      tables_done_ = false;
+}
+
+/*
+ * Collect the nodes, components and port connections of the
+ * island. This is done the first time the island runs, when linking
+ * is complete.
+ */
+void vvp_island_tran::build_tables_()
+{
+      vector<vvp_island_branch_tran*> branch_tab;
+      for (vvp_island_branch*cur = branches_ ; cur ; cur = cur->next_branch)
+	    branch_tab.push_back(BRANCH_TRAN(cur));
+
+	// Collect the ends of each node. The ends of a node are kept
+	// in the order of the circular list of the node, so that the
+	// scans below visit them in the same order as the list does.
+      ends_.resize(2*branch_tab.size());
+      nodes_.reserve(2*branch_tab.size());
+      unsigned nends = 0;
+      for (unsigned idx = 0 ; idx < branch_tab.size() ; idx += 1) {
+	    for (unsigned ab = 0 ; ab < 2 ; ab += 1) {
+		  if (branch_tab[idx]->node[ab])
+			continue;
+
+		  list<vvp_branch_ptr_t> conn;
+		  island_collect_node(conn, vvp_branch_ptr_t(branch_tab[idx], ab));
+
+		  tran_node_s node;
+		  node.ends = &ends_[nends];
+		  node.count = conn.size();
+		  nodes_.push_back(node);
+
+		  unsigned pos = 0;
+		  for (list<vvp_branch_ptr_t>::iterator cur = conn.begin()
+			     ; cur != conn.end() ; ++ cur, ++ pos) {
+			vvp_island_branch_tran*tmp = BRANCH_TRAN(cur->ptr());
+			unsigned tmp_ab = cur->port();
+			ends_[nends].ptr = tmp;
+			ends_[nends].ab = tmp_ab;
+			tmp->node[tmp_ab] = &nodes_.back();
+			tmp->node_pos[tmp_ab] = pos;
+			nends += 1;
+		  }
+	    }
+      }
+      assert(nends == ends_.size());
+
+	// The branches join their A and B nodes into components.
+      vector<unsigned> parent (nodes_.size());
+      for (unsigned idx = 0 ; idx < parent.size() ; idx += 1)
+	    parent[idx] = idx;
+
+      for (unsigned idx = 0 ; idx < branch_tab.size() ; idx += 1) {
+	    unsigned na = find_root(parent, branch_tab[idx]->node[0] - &nodes_[0]);
+	    unsigned nb = find_root(parent, branch_tab[idx]->node[1] - &nodes_[0]);
+	    if (na != nb) parent[nb] = na;
+      }
+
+	// Number the components in the order of their first branch,
+	// and sort the branches by component.
+      vector<unsigned> comp_of_root (nodes_.size(), UINT_MAX);
+      vector<unsigned> branch_comp (branch_tab.size());
+      unsigned ncomps = 0;
+      for (unsigned idx = 0 ; idx < branch_tab.size() ; idx += 1) {
+	    unsigned root = find_root(parent, branch_tab[idx]->node[0] - &nodes_[0]);
+	    if (comp_of_root[root] == UINT_MAX)
+		  comp_of_root[root] = ncomps++;
+	    branch_comp[idx] = comp_of_root[root];
+      }
+
+      comp_start_.assign(ncomps+1, 0);
+      for (unsigned idx = 0 ; idx < branch_tab.size() ; idx += 1)
+	    comp_start_[branch_comp[idx]+1] += 1;
+      for (unsigned idx = 0 ; idx < ncomps ; idx += 1)
+	    comp_start_[idx+1] += comp_start_[idx];
+
+      comp_branch_.resize(branch_tab.size());
+      vector<unsigned> fill (comp_start_.begin(), comp_start_.end()-1);
+      for (unsigned idx = 0 ; idx < branch_tab.size() ; idx += 1)
+	    comp_branch_[fill[branch_comp[idx]]++] = branch_tab[idx];
+
+	// Number the ports, and note the components that each port
+	// connects to or enables.
+      map<vvp_island_port*,unsigned> port_map;
+      vector<pair<unsigned,unsigned> > port_use;
+      vector<bool> is_end, is_enable;
+      for (unsigned idx = 0 ; idx < branch_tab.size() ; idx += 1) {
+	    vvp_island_branch_tran*cur = branch_tab[idx];
+	    vvp_island_port*ports[3];
+	    ports[0] = ISLAND_PORT(cur->a);
+	    ports[1] = ISLAND_PORT(cur->b);
+	    ports[2] = cur->en? dynamic_cast<vvp_island_port*>(cur->en->fun) : 0;
+	    cur->en_port = ports[2];
+
+	    for (unsigned pdx = 0 ; pdx < 3 ; pdx += 1) {
+		  if (ports[pdx] == 0)
+			continue;
+
+		  map<vvp_island_port*,unsigned>::iterator cur_port = port_map.find(ports[pdx]);
+		  unsigned pidx;
+		  if (cur_port == port_map.end()) {
+			pidx = port_map.size();
+			port_map[ports[pdx]] = pidx;
+			ports[pdx]->index = pidx;
+			is_end.push_back(false);
+			is_enable.push_back(false);
+		  } else {
+			pidx = cur_port->second;
+		  }
+
+		  if (pdx < 2) is_end[pidx] = true;
+		  else is_enable[pidx] = true;
+		  port_use.push_back(make_pair(pidx, branch_comp[idx]));
+	    }
+      }
+
+      sort(port_use.begin(), port_use.end());
+      port_use.erase(unique(port_use.begin(), port_use.end()), port_use.end());
+
+      port_start_.assign(port_map.size()+1, 0);
+      port_comp_.resize(port_use.size());
+      for (unsigned idx = 0 ; idx < port_use.size() ; idx += 1) {
+	    port_start_[port_use[idx].first+1] += 1;
+	    port_comp_[idx] = port_use[idx].second;
+      }
+      for (unsigned idx = 0 ; idx < port_map.size() ; idx += 1)
+	    port_start_[idx+1] += port_start_[idx];
+
+	// An enable that is also connected to a branch reads the
+	// value that the island drives out. Keep these so that a
+	// change in that value can be noticed.
+      for (map<vvp_island_port*,unsigned>::iterator cur = port_map.begin()
+		 ; cur != port_map.end() ; ++ cur ) {
+	    if (is_end[cur->second] && is_enable[cur->second]) {
+		  fb_port_.push_back(cur->first);
+		  fb_value_.push_back(BIT4_Z);
+	    }
+      }
+
+	// The first run resolves the whole island.
+      comp_dirty_.assign(ncomps, true);
+      for (unsigned idx = 0 ; idx < ncomps ; idx += 1)
+	    dirty_list_.push_back(idx);
+
+      tables_done_ = true;
+}
+
+void vvp_island_tran::mark_port_dirty_(const vvp_island_port*port)
+{
+      if (port->index >= port_start_.size()-1)
+	    return;
+
+      for (unsigned idx = port_start_[port->index]
+		 ; idx < port_start_[port->index+1] ; idx += 1) {
+	    unsigned comp = port_comp_[idx];
+	    if (comp_dirty_[comp])
+		  continue;
+	    comp_dirty_[comp] = true;
+	    dirty_list_.push_back(comp);
+      }
+}
+
+static vvp_bit4_t enable_value(const vvp_island_port*ep)
+{
+      if (ep->outvalue.size() != 0)
+	    return ep->outvalue.value(0).value();
+      else if (ep->invalue.size() == 0)
+	    return BIT4_Z;
+      else
+	    return ep->invalue.value(0).value();
+}
+
 /*
  * The run_island() method is called by the scheduler to run the
- * entire island. We run the island by calling run_resolution() for
- * all the branches in the island.
+ * island. We run the island by calling run_resolution() for all the
+ * branches of the components that the flagged ports touch. The other
+ * components have the same inputs and enables as the last time they
+ * ran, so they would resolve to the same values.
 */
 void vvp_island_tran::run_island()
 {
+      if (! tables_done_)
+	    build_tables_();
+
+      for (unsigned idx = 0 ; idx < flagged_ports_.size() ; idx += 1) {
+	    flagged_ports_[idx]->flagged = false;
+	    mark_port_dirty_(flagged_ports_[idx]);
+      }
+      flagged_ports_.clear();
+
+      vector<unsigned> todo;
+      todo.swap(dirty_list_);
+      for (unsigned idx = 0 ; idx < todo.size() ; idx += 1)
+	    comp_dirty_[todo[idx]] = false;
+      sort(todo.begin(), todo.end());
+
 	// Test to see if any of the branches are enabled. This loop
-	// tests the enabled inputs for all the branches and caches
-	// the results in the enabled_flag for each branch. The
+	// tests the enabled inputs for the branches and caches the
+	// results in the enabled_flag for each branch. The
 	// run_test_enabled() method also clears all the processing
 	// flags for the branches so that we are in a good start
 	// state.
-      bool runnable = false;
-      for (vvp_island_branch*cur = branches_ ; cur ; cur = cur->next_branch) {
-	    vvp_island_branch_tran*tmp = dynamic_cast<vvp_island_branch_tran*>(cur);
-	    assert(tmp);
-	    runnable |= tmp->run_test_enabled();
+      for (unsigned idx = 0 ; idx < todo.size() ; idx += 1) {
+	    unsigned comp = todo[idx];
+	    for (unsigned bdx = comp_start_[comp]
+		       ; bdx < comp_start_[comp+1] ; bdx += 1)
+		  comp_branch_[bdx]->run_test_enabled();
       }
 
-	// Now resolve all the branches in the island.
-      for (vvp_island_branch*cur = branches_ ; cur ; cur = cur->next_branch) {
-	    vvp_island_branch_tran*tmp = dynamic_cast<vvp_island_branch_tran*>(cur);
-	    assert(tmp);
-	    tmp->run_resolution();
+	// Now resolve the branches.
+      for (unsigned idx = 0 ; idx < todo.size() ; idx += 1) {
+	    unsigned comp = todo[idx];
+	    for (unsigned bdx = comp_start_[comp]
+		       ; bdx < comp_start_[comp+1] ; bdx += 1)
+		  comp_branch_[bdx]->run_resolution();
+      }
+
+	// If the island changed the value of an enable that it reads
+	// back, then the components of that enable are out of date.
+	// They are resolved again the next time the island runs, as
+	// the whole island would have been.
+      for (unsigned idx = 0 ; idx < fb_port_.size() ; idx += 1) {
+	    vvp_bit4_t val = enable_value(fb_port_[idx]);
+	    if (val == fb_value_[idx])
+		  continue;
+	    fb_value_[idx] = val;
+	    mark_port_dirty_(fb_port_[idx]);
       }
 }
 
@@ -115,7 +401,7 @@ bool vvp_island_branch_tran::run_test_enabled()
 	// Clear all the flags.
       clear_resolution_flags();
 
-      vvp_island_port*ep = en? dynamic_cast<vvp_island_port*> (en->fun) : 0;
+      vvp_island_port*ep = en_port;
 
 	// If there is no ep port (no "enabled" input) then this is a
 	// tran branch. Assume it is always enabled.
@@ -140,13 +426,7 @@ bool vvp_island_branch_tran::run_test_enabled()
 	// If the outvalue is nil, then we know that this port is a
 	// .import after all, so just read the invalue.
       enabled_flag = false;
-      vvp_bit4_t enable_val;
-      if (ep->outvalue.size() != 0)
-	    enable_val = ep->outvalue.value(0).value();
-      else if (ep->invalue.size() == 0)
-	    enable_val = BIT4_Z;
-      else
-	    enable_val = ep->invalue.value(0).value();
+      vvp_bit4_t enable_val = enable_value(ep);
 
       if (active_high==true && enable_val != BIT4_1)
 	    return false;
@@ -158,65 +438,46 @@ bool vvp_island_branch_tran::run_test_enabled()
       return true;
 }
 
-static void island_send_value(list<vvp_branch_ptr_t>&connections, const vvp_vector8_t&val)
+/*
+ * These functions scan the ends of a node, starting with the end at
+ * position pos, in the order that the circular list of the node
+ * would visit them.
+ */
+static void island_send_value(const tran_node_s*node, unsigned pos,
+			      const vvp_vector8_t&val)
 {
-      for (list<vvp_branch_ptr_t>::iterator idx = connections.begin()
-		 ; idx != connections.end() ; ++ idx ) {
-
-	    vvp_island_branch*tmp_ptr = idx->ptr();
-
-	    unsigned tmp_ab = idx->port();
-	    island_send_value(tmp_ab? tmp_ptr->b : tmp_ptr->a, val);
+      for (unsigned idx = 0 ; idx < node->count ; idx += 1) {
+	    const tran_end_s&cur = node->ends[(pos+idx) % node->count];
+	    island_send_value(cur.ab? cur.ptr->b : cur.ptr->a, val);
       }
 }
 
-static void mark_done_flags(list<vvp_branch_ptr_t>&connections)
+static void mark_done_flags(const tran_node_s*node)
 {
-      for (list<vvp_branch_ptr_t>::iterator idx = connections.begin()
-		 ; idx != connections.end() ; ++ idx ) {
-
-	    vvp_island_branch*tmp_ptr = idx->ptr();
-	    vvp_island_branch_tran*cur = dynamic_cast<vvp_island_branch_tran*>(tmp_ptr);
-
-	    unsigned tmp_ab = idx->port();
-	    cur->mark_done(tmp_ab);
-      }
+      for (unsigned idx = 0 ; idx < node->count ; idx += 1)
+	    node->ends[idx].ptr->mark_done(node->ends[idx].ab);
 }
 
-static void mark_visited_flags(list<vvp_branch_ptr_t>&connections)
+static void mark_visited_flags(const tran_node_s*node)
 {
-      for (list<vvp_branch_ptr_t>::iterator idx = connections.begin()
-		 ; idx != connections.end() ; ++ idx ) {
-
-	    vvp_island_branch*tmp_ptr = idx->ptr();
-	    vvp_island_branch_tran*cur = dynamic_cast<vvp_island_branch_tran*>(tmp_ptr);
-	    assert(cur);
-
-	    unsigned tmp_ab = idx->port();
-	    cur->mark_visited(tmp_ab);
-      }
+      for (unsigned idx = 0 ; idx < node->count ; idx += 1)
+	    node->ends[idx].ptr->mark_visited(node->ends[idx].ab);
 }
 
-static void clear_visited_flags(list<vvp_branch_ptr_t>&connections)
+static void clear_visited_flags(const tran_node_s*node)
 {
-      for (list<vvp_branch_ptr_t>::iterator idx = connections.begin()
-		 ; idx != connections.end() ; ++ idx ) {
-
-	    vvp_island_branch_tran*tmp_ptr = BRANCH_TRAN(idx->ptr());
-
-	    unsigned tmp_ab = idx->port();
-	    tmp_ptr->clear_visited(tmp_ab);
-      }
+      for (unsigned idx = 0 ; idx < node->count ; idx += 1)
+	    node->ends[idx].ptr->clear_visited(node->ends[idx].ab);
 }
 
-static vvp_vector8_t get_value_from_branch(vvp_branch_ptr_t cur);
+static vvp_vector8_t get_value_from_branch(const tran_end_s&cur);
 
 static void resolve_values_from_connections(vvp_vector8_t&val,
-					    list<vvp_branch_ptr_t>&connections)
+					    const tran_node_s*node,
+					    unsigned pos)
 {
-      for (list<vvp_branch_ptr_t>::iterator idx = connections.begin()
-		 ; idx != connections.end() ; ++ idx ) {
-	    vvp_vector8_t tmp = get_value_from_branch(*idx);
+      for (unsigned idx = 0 ; idx < node->count ; idx += 1) {
+	    vvp_vector8_t tmp = get_value_from_branch(node->ends[(pos+idx) % node->count]);
 	    if (val.size() == 0)
 		  val = tmp;
 	    else if (tmp.size() != 0)
@@ -224,19 +485,16 @@ static void resolve_values_from_connections(vvp_vector8_t&val,
       }
 }
 
-static vvp_vector8_t get_value_from_branch(vvp_branch_ptr_t cur)
+static vvp_vector8_t get_value_from_branch(const tran_end_s&cur)
 {
-      vvp_island_branch_tran*ptr = BRANCH_TRAN(cur.ptr());
-      assert(ptr);
-      unsigned ab = cur.port();
+      vvp_island_branch_tran*ptr = cur.ptr;
+      unsigned ab = cur.ab;
       unsigned ab_other = ab^1;
 
 	// If the branch link is disabled, return nil.
       if (ptr->enabled_flag == false)
 	    return vvp_vector8_t();
 
-      vvp_branch_ptr_t other (ptr, ab_other);
-
 	// If the branch other side is already visited, return
 	// nil. This prevents recursion loops.
       if (ptr->test_visited(ab_other))
@@ -247,14 +505,13 @@ static vvp_vector8_t get_value_from_branch(vvp_branch_ptr_t cur)
       vvp_vector8_t val_other = island_get_value(net_other);
 
 	// recurse
-      list<vvp_branch_ptr_t> connections;
-      island_collect_node(connections, other);
-      mark_visited_flags(connections);
+      const tran_node_s*node = ptr->node[ab_other];
+      mark_visited_flags(node);
 
-      resolve_values_from_connections(val_other, connections);
+      resolve_values_from_connections(val_other, node, ptr->node_pos[ab_other]);
 
 	// Remove/unwind visited flags
-      clear_visited_flags(connections);
+      clear_visited_flags(node);
 
       if (val_other.size() == 0)
 	    return val_other;
@@ -278,19 +535,18 @@ static vvp_vector8_t get_value_from_branch(vvp_branch_ptr_t cur)
  * marking as done that are obviously and easily done. But it is
  * better to be conservative here.
  *
- * The connections list is filled with connections that are already
- * marked done, and the val is the resolved value. We are going to try
- * to follow branches to see if we can push the value further and mark
- * the other side done as well.
+ * The node ends are already marked done, and the val is the resolved
+ * value. We are going to try to follow branches to see if we can
+ * push the value further and mark the other side done as well.
  */
 static void push_value_through_branches(const vvp_vector8_t&val,
-					list<vvp_branch_ptr_t>&connections)
+					const tran_node_s*node, unsigned pos)
 {
-      for (list<vvp_branch_ptr_t>::iterator idx = connections.begin()
-		 ; idx != connections.end() ; ++ idx ) {
+      for (unsigned idx = 0 ; idx < node->count ; idx += 1) {
 
-	    vvp_island_branch_tran*tmp_ptr = BRANCH_TRAN(idx->ptr());
-	    unsigned tmp_ab = idx->port();
+	    const tran_end_s&cur = node->ends[(pos+idx) % node->count];
+	    vvp_island_branch_tran*tmp_ptr = cur.ptr;
+	    unsigned tmp_ab = cur.ab;
 	    unsigned other_ab = tmp_ab^1;
 
 	      // If other side already done, skip
@@ -331,9 +587,6 @@ static void push_value_through_branches(const vvp_vector8_t&val,
  */
 void vvp_island_branch_tran::run_resolution()
 {
-	// Collect all the branch endpoints that are joined to my A
-	// side.
-      list<vvp_branch_ptr_t> connections;
       bool processed_a_side = false;
       vvp_vector8_t val;
 
@@ -346,37 +599,35 @@ void vvp_island_branch_tran::run_resolution()
 	// If the A side has already been completed, then skip it.
       if (! test_done(0)) {
 	    processed_a_side = true;
-	    vvp_branch_ptr_t a_side(this, 0);
-	    island_collect_node(connections, a_side);
 
 	      // Mark my A side as done. Do this early to prevent recursing
 	      // back. All the connections that share this port are also
 	      // done. Make sure their flags are set appropriately.
-	    mark_done_flags(connections);
+	    mark_done_flags(node[0]);
 
 	      // Start with my branch-point value.
 	    val = island_get_value(a);
-	    mark_visited_flags(connections); // Mark as visited.
+	    mark_visited_flags(node[0]); // Mark as visited.
 
 
 	      // Now scan the other sides of all the branches connected to
 	      // my A side. The get_value_from_branch() will recurse as
 	      // necessary to depth-first walk the graph.
-	    resolve_values_from_connections(val, connections);
+	    resolve_values_from_connections(val, node[0], node_pos[0]);
 
 	      // A side is done.
-	    island_send_value(connections, val);
+	    island_send_value(node[0], node_pos[0], val);
 
 	      // Clear the visited flags. This must be done so that other
 	      // branches can read this input value.
-	    clear_visited_flags(connections);
+	    clear_visited_flags(node[0]);
 
 	      // Try to push the calculated value out through the
 	      // branches. This is useful for A-side results because
 	      // there is a high probability that the other side of
 	      // all the connected branches is fully specified by this
 	      // result.
-	    push_value_through_branches(val, connections);
+	    push_value_through_branches(val, node[0], node_pos[0]);
       }
 
 	// If the B side got taken care of by above, then this branch
@@ -386,9 +637,7 @@ void vvp_island_branch_tran::run_resolution()
 
 	// Repeat the above for the B side.
 
-      connections.clear();
-      island_collect_node(connections, vvp_branch_ptr_t(this, 1));
-      mark_done_flags(connections);
+      mark_done_flags(node[1]);
 
       if (enabled_flag && processed_a_side) {
 	      // If this is a connected branch, then we know from the
@@ -406,12 +655,12 @@ void vvp_island_branch_tran::run_resolution()
 	      // If this branch is not enabled, then the B-side must
 	      // be processed on its own.
 	    val = island_get_value(b);
-	    mark_visited_flags(connections);
-	    resolve_values_from_connections(val, connections);
-	    clear_visited_flags(connections);
+	    mark_visited_flags(node[1]);
+	    resolve_values_from_connections(val, node[1], node_pos[1]);
+	    clear_visited_flags(node[1]);
       }
 
-      island_send_value(connections, val);
+      island_send_value(node[1], node_pos[1], val);
 }
 
 void compile_island_tran(char*label)
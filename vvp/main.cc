@@ -25,6 +25,7 @@
 # include  "schedule.h"
 # include  "vpi_priv.h"
 # include  "statistics.h"
+# include  "profile.h"
 # include  "vvp_cleanup.h"
 # include  <cstdio>
 # include  <cstdlib>
@@ -92,7 +93,7 @@ static void my_getrusage(struct rusage *a)
 #     endif
 }
 
-static void print_rusage(struct rusage *a, struct rusage *b)
+static double print_rusage(struct rusage *a, struct rusage *b)
 {
       double delta = a->ru_utime.tv_sec
 	    +        a->ru_utime.tv_usec/1E6
@@ -111,6 +112,8 @@ static void print_rusage(struct rusage *a, struct rusage *b)
 	      a->ru_maxrss/1024.0,
 	      (a->ru_idrss+a->ru_isrss)/1024.0,
 	      a->ru_ixrss/1024.0 );
+
+      return delta;
 }
 
 #else // ! defined(HAVE_SYS_RESOURCE_H)
@@ -118,7 +121,8 @@ static void print_rusage(struct rusage *a, struct rusage *b)
 // Provide dummies
 struct rusage { int x; };
 inline static void my_getrusage(struct rusage *) { }
-inline static void print_rusage(struct rusage *, struct rusage *){};
+inline static double print_rusage(struct rusage *, struct rusage *)
+{ return 0.0; }
 
 #endif // ! defined(HAVE_SYS_RESOURCE_H)
 
@@ -243,6 +247,7 @@ int main(int argc, char*argv[])
       const char*design_path = 0;
       struct rusage cycles[3];
       const char *logfile_name = 0x0;
+      const char *profile_path = 0x0;
       FILE *logfile = 0x0;
       extern void vpi_set_vlog_info(int, char**);
       extern bool stop_is_finish;
@@ -280,7 +285,7 @@ int main(int argc, char*argv[])
         /* For non-interactive runs we do not want to run the interactive
          * debugger, so make $stop just execute a $finish. */
       stop_is_finish = false;
-      while ((opt = getopt(argc, argv, "+hl:M:m:nNsvV")) != EOF) switch (opt) {
+      while ((opt = getopt(argc, argv, "+hl:M:m:nNp:svV")) != EOF) switch (opt) {
          case 'h':
            fprintf(stderr,
                    "Usage: vvp [options] input-file [+plusargs...]\n"
@@ -292,6 +297,7 @@ int main(int argc, char*argv[])
                    " -m module      Load vpi module.\n"
 		   " -n             Non-interactive ($stop = $finish).\n"
                    " -N             Same as -n, but exit code is 1 instead of 0\n"
+                   " -p file        Profile the simulation, write the counts to file.\n"
 		   " -s             $stop right away.\n"
                    " -v             Verbose progress messages.\n"
                    " -V             Print the version information.\n" );
@@ -317,6 +323,10 @@ int main(int argc, char*argv[])
             stop_is_finish = true;
             stop_is_finish_exit_code = 1;
             break;
+	  case 'p':
+	    profile_path = optarg;
+	    profile_flag = true;
+	    break;
 	  case 's':
 	    schedule_stop(0);
 	    break;
@@ -367,6 +377,20 @@ int main(int argc, char*argv[])
 	    debug_file.open(path, ios::out);
       }
 
+	/* If the VVP_SCHEDULER variable is set, then it selects the
+	   time queue that the scheduler uses. */
+
+      if (char*queue = getenv("VVP_SCHEDULER")) {
+	    if (strcmp(queue, "wheel") == 0) {
+		  schedule_set_time_wheel(true);
+	    } else if (strcmp(queue, "list") == 0) {
+		  schedule_set_time_wheel(false);
+	    } else {
+		  fprintf(stderr, "%s: Unknown VVP_SCHEDULER=%s, "
+			  "expecting wheel or list.\n", argv[0], queue);
+	    }
+      }
+
       design_path = argv[optind];
 
 	/* This is needed to get the MCD I/O routines ready for
@@ -450,6 +474,7 @@ int main(int argc, char*argv[])
 	    vpi_mcd_printf(1, " ... %8lu opcodes (%zu bytes)\n",
 #endif
 	                   count_opcodes, size_opcodes);
+	    vpi_mcd_printf(1, "           %8lu fused\n", count_opcodes_fused);
 	    vpi_mcd_printf(1, " ... %8lu nets\n",     count_vpi_nets);
 #ifdef __MINGW32__  /* MinGW does not know about z. */
 	    vpi_mcd_printf(1, " ... %8lu vvp_nets (%u bytes)\n",
@@ -479,11 +504,27 @@ int main(int argc, char*argv[])
 
       if (verbose_flag) {
 	    my_getrusage(cycles+2);
-	    print_rusage(cycles+2, cycles+1);
+	    double run_time = print_rusage(cycles+2, cycles+1);
+
+	    unsigned long count_instructions = count_opcode_dispatches
+		  + count_opcode_fused_steps;
+	    vpi_mcd_printf(1, " ... %8lu instructions", count_instructions);
+	    if (run_time > 0.0)
+		  vpi_mcd_printf(1, " (%.0f per second)",
+				 count_instructions / run_time);
+	    vpi_mcd_printf(1, "\n");
+	    vpi_mcd_printf(1, " ... %8lu opcode dispatches", count_opcode_dispatches);
+	    if (run_time > 0.0)
+		  vpi_mcd_printf(1, " (%.0f per second)",
+				 count_opcode_dispatches / run_time);
+	    vpi_mcd_printf(1, "\n");
 
 	    vpi_mcd_printf(1, "Event counts:\n");
 	    vpi_mcd_printf(1, "    %8lu time steps (pool=%lu)\n",
 			   count_time_events, count_time_pool());
+	    vpi_mcd_printf(1, "             ...%s time queue, %lu overflow\n",
+			   schedule_time_wheel()? "wheel" : "list",
+			   count_time_overflow);
 	    vpi_mcd_printf(1, "    %8lu thread schedule events\n",
 		    count_thread_events);
 	    vpi_mcd_printf(1, "    %8lu assign events\n",
@@ -500,8 +541,19 @@ int main(int argc, char*argv[])
 			   count_assign_arword_pool());
 	    vpi_mcd_printf(1, "    %8lu other events (pool=%lu)\n",
 			   count_gen_events, count_gen_pool());
+	    vpi_mcd_printf(1, "    %8lu delayed transitions (%lu cancelled)\n",
+			   count_delay_scheduled, count_delay_cancelled);
+
+	    vpi_mcd_printf(1, "Vector counts:\n");
+	    vpi_mcd_printf(1, "    %8lu vec4 allocations\n",
+			   count_vector4_allocs);
+	    vpi_mcd_printf(1, "    %8lu vec4 shared copies (%lu unshared)\n",
+			   count_vector4_shared, count_vector4_unshared);
       }
 
+      if (profile_flag)
+	    profile_report(profile_path);
+
       final_cleanup();
 
       return vvp_return_value;
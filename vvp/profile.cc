@@ -0,0 +1,364 @@
+/*
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA
+ */
+
+# include  "profile.h"
+# include  "codes.h"
+# include  "vpi_priv.h"
+# include  "vvp_net.h"
+# include  "vvp_net_sig.h"
+# include  "vvp_island.h"
+# include  "event.h"
+# include  "delay.h"
+# include  "sfunc.h"
+# include  <map>
+# include  <string>
+# include  <vector>
+# include  <algorithm>
+# include  <cstdio>
+# include  <cstdlib>
+#if defined(__GNUC__)
+# include  <cxxabi.h>
+#endif
+
+bool profile_flag = false;
+
+/*
+ * The counts are kept in maps keyed by the thing being counted. The
+ * maps are only touched when profiling is enabled, so the cost of the
+ * lookups is not paid by normal runs.
+ */
+static std::map<vvp_code_fun,unsigned long> opcode_counts;
+
+static std::map<const char*,unsigned long> recv_counts;
+
+struct scope_profile_s {
+      scope_profile_s() : slices(0), opcodes(0), cpu(0) { }
+      unsigned long slices;
+      unsigned long opcodes;
+      clock_t cpu;
+};
+static std::map<struct __vpiScope*,scope_profile_s> scope_counts;
+
+struct event_profile_s {
+      event_profile_s() : count(0), step_count(0), step_max(0) { }
+      unsigned long count;
+      unsigned long step_count;
+      unsigned long step_max;
+};
+static std::map<const char*,event_profile_s> event_counts;
+static unsigned long profile_time_steps = 0;
+
+void profile_opcode(const struct vvp_code_s*code)
+{
+      opcode_counts[code->opcode] += 1;
+}
+
+void profile_thread(struct __vpiScope*scope, unsigned long opcodes,
+		    clock_t cpu)
+{
+      scope_profile_s&cur = scope_counts[scope];
+      cur.slices += 1;
+      cur.opcodes += opcodes;
+      cur.cpu += cpu;
+}
+
+/*
+ * The profile_recv_fun is put in front of the functor of a net when
+ * the design is linked. It counts each value delivered to the net
+ * under the class of the wrapped functor, then passes the value on.
+ * The count is kept by pointer because the map nodes do not move.
+ */
+class profile_recv_fun : public vvp_net_fun_t {
+
+    public:
+      explicit profile_recv_fun(vvp_net_fun_t*fun)
+      : fun_(fun), count_(&recv_counts[typeid(*fun).name()]) { }
+
+      void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+		     vvp_context_t context)
+      { *count_ += 1; fun_->recv_vec4(port, bit, context); }
+
+      void recv_vec8(vvp_net_ptr_t port, const vvp_vector8_t&bit)
+      { *count_ += 1; fun_->recv_vec8(port, bit); }
+
+      void recv_real(vvp_net_ptr_t port, double bit, vvp_context_t context)
+      { *count_ += 1; fun_->recv_real(port, bit, context); }
+
+      void recv_long(vvp_net_ptr_t port, long bit)
+      { *count_ += 1; fun_->recv_long(port, bit); }
+
+      void recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+			unsigned base, unsigned wid, unsigned vwid,
+			vvp_context_t context)
+      { *count_ += 1; fun_->recv_vec4_pv(port, bit, base, wid, vwid, context); }
+
+      void recv_vec8_pv(vvp_net_ptr_t port, const vvp_vector8_t&bit,
+			unsigned base, unsigned wid, unsigned vwid)
+      { *count_ += 1; fun_->recv_vec8_pv(port, bit, base, wid, vwid); }
+
+      void recv_long_pv(vvp_net_ptr_t port, long bit,
+			unsigned base, unsigned wid)
+      { *count_ += 1; fun_->recv_long_pv(port, bit, base, wid); }
+
+      void force_flag(void)
+      { fun_->force_flag(); }
+
+    private:
+      vvp_net_fun_t*fun_;
+      unsigned long*count_;
+};
+
+static std::vector<vvp_net_t*> profile_nets;
+
+void profile_net(vvp_net_t*net)
+{
+      profile_nets.push_back(net);
+}
+
+/*
+ * The run time finds some functors again with a dynamic_cast of
+ * net->fun: signals, events, island ports, modpath sources and system
+ * function cores. Those are left as they are, and so the values they
+ * receive are not counted. A net may also be listed more than once.
+ */
+static bool profile_can_wrap_(vvp_net_fun_t*fun)
+{
+      if (fun == 0)
+	    return false;
+      if (dynamic_cast<profile_recv_fun*>(fun))
+	    return false;
+      if (dynamic_cast<vvp_fun_signal_base*>(fun))
+	    return false;
+      if (dynamic_cast<waitable_hooks_s*>(fun))
+	    return false;
+      if (dynamic_cast<vvp_island_port*>(fun))
+	    return false;
+      if (dynamic_cast<vvp_fun_modpath_src*>(fun))
+	    return false;
+      if (dynamic_cast<sfunc_core*>(fun))
+	    return false;
+      return true;
+}
+
+void profile_wrap_nets(void)
+{
+      for (size_t idx = 0 ;  idx < profile_nets.size() ;  idx += 1) {
+	    vvp_net_t*net = profile_nets[idx];
+	    if (profile_can_wrap_(net->fun))
+		  net->fun = new profile_recv_fun(net->fun);
+      }
+
+      std::vector<vvp_net_t*>().swap(profile_nets);
+}
+
+void profile_event(const std::type_info&type)
+{
+      event_profile_s&cur = event_counts[type.name()];
+      cur.count += 1;
+      cur.step_count += 1;
+}
+
+void profile_time_step(void)
+{
+      profile_time_steps += 1;
+
+      for (std::map<const char*,event_profile_s>::iterator cur = event_counts.begin()
+		 ; cur != event_counts.end() ; ++ cur ) {
+	    event_profile_s&tmp = cur->second;
+	    if (tmp.step_count > tmp.step_max)
+		  tmp.step_max = tmp.step_count;
+	    tmp.step_count = 0;
+      }
+}
+
+/*
+ * The type names from typeid are mangled by some compilers. Make them
+ * readable where we know how.
+ */
+static std::string type_name_(const char*name)
+{
+#if defined(__GNUC__)
+      int status = 0;
+      char*tmp = abi::__cxa_demangle(name, 0, 0, &status);
+      if (status == 0 && tmp) {
+	    std::string res (tmp);
+	    free(tmp);
+	    return res;
+      }
+#endif
+      return name;
+}
+
+static std::string scope_name_(struct __vpiScope*scope)
+{
+      if (scope == 0)
+	    return "<none>";
+      return vpi_get_str(vpiFullName, &scope->base);
+}
+
+static std::string opcode_name_(vvp_code_fun fun)
+{
+      const char*name = opcode_mnemonic(fun);
+      return name? name : "<internal>";
+}
+
+static void json_string_(FILE*fd, const std::string&str)
+{
+      fputc('"', fd);
+      for (size_t idx = 0 ;  idx < str.size() ;  idx += 1) {
+	    unsigned char ch = str[idx];
+	    if (ch == '"' || ch == '\\')
+		  fprintf(fd, "\\%c", ch);
+	    else if (ch < 0x20)
+		  fprintf(fd, "\\u%04x", ch);
+	    else
+		  fputc(ch, fd);
+      }
+      fputc('"', fd);
+}
+
+/*
+ * The report lists are sorted by decreasing count, so the hot items
+ * come first.
+ */
+typedef std::pair<unsigned long,std::string> profile_item_t;
+
+static bool item_compare_(const profile_item_t&a, const profile_item_t&b)
+{
+      if (a.first != b.first)
+	    return a.first > b.first;
+      return a.second < b.second;
+}
+
+static bool scope_compare_(const std::pair<unsigned long,struct __vpiScope*>&a,
+			   const std::pair<unsigned long,struct __vpiScope*>&b)
+{
+      return a.first > b.first;
+}
+
+static const size_t REPORT_TOP = 20;
+
+static void print_items_(const char*title, std::vector<profile_item_t>&items)
+{
+      vpi_mcd_printf(1, "%s:\n", title);
+      for (size_t idx = 0 ;  idx < items.size() && idx < REPORT_TOP ;  idx += 1)
+	    vpi_mcd_printf(1, "    %12lu %s\n", items[idx].first,
+			   items[idx].second.c_str());
+      if (items.size() > REPORT_TOP)
+	    vpi_mcd_printf(1, "    ... %u more\n",
+			   (unsigned)(items.size()-REPORT_TOP));
+}
+
+static void json_items_(FILE*fd, const char*key, const char*label,
+			std::vector<profile_item_t>&items)
+{
+      fprintf(fd, "  \"%s\": [", key);
+      for (size_t idx = 0 ;  idx < items.size() ;  idx += 1) {
+	    fprintf(fd, "%s\n    { \"%s\": ", idx? "," : "", label);
+	    json_string_(fd, items[idx].second);
+	    fprintf(fd, ", \"count\": %lu }", items[idx].first);
+      }
+      fprintf(fd, "\n  ]");
+}
+
+void profile_report(const char*path)
+{
+	/* Close out the last time step. */
+      profile_time_step();
+
+      std::vector<profile_item_t> opcodes;
+      for (std::map<vvp_code_fun,unsigned long>::iterator cur = opcode_counts.begin()
+		 ; cur != opcode_counts.end() ; ++ cur ) {
+	    opcodes.push_back(profile_item_t(cur->second,
+					     opcode_name_(cur->first)));
+      }
+      std::sort(opcodes.begin(), opcodes.end(), item_compare_);
+
+      std::vector<profile_item_t> functors;
+      for (std::map<const char*,unsigned long>::iterator cur = recv_counts.begin()
+		 ; cur != recv_counts.end() ; ++ cur ) {
+	    functors.push_back(profile_item_t(cur->second,
+					      type_name_(cur->first)));
+      }
+      std::sort(functors.begin(), functors.end(), item_compare_);
+
+	/* Sort the scopes by the number of opcodes they executed. */
+      std::vector<std::pair<unsigned long,struct __vpiScope*> > scope_list;
+      for (std::map<struct __vpiScope*,scope_profile_s>::iterator cur = scope_counts.begin()
+		 ; cur != scope_counts.end() ; ++ cur ) {
+	    scope_list.push_back(std::make_pair(cur->second.opcodes, cur->first));
+      }
+      std::sort(scope_list.begin(), scope_list.end(), scope_compare_);
+
+      std::vector<profile_item_t> scopes;
+      for (size_t idx = 0 ;  idx < scope_list.size() ;  idx += 1) {
+	    scopes.push_back(profile_item_t(scope_list[idx].first,
+					    scope_name_(scope_list[idx].second)));
+      }
+
+      std::vector<profile_item_t> events;
+      for (std::map<const char*,event_profile_s>::iterator cur = event_counts.begin()
+		 ; cur != event_counts.end() ; ++ cur ) {
+	    events.push_back(profile_item_t(cur->second.count,
+					    type_name_(cur->first)));
+      }
+      std::sort(events.begin(), events.end(), item_compare_);
+
+      vpi_mcd_printf(1, "Profile:\n");
+      print_items_("  opcodes executed", opcodes);
+      print_items_("  functor inputs received", functors);
+      print_items_("  opcodes executed by scope", scopes);
+      print_items_("  events run", events);
+      vpi_mcd_printf(1, "  %lu time steps\n", profile_time_steps);
+
+      FILE*fd = fopen(path, "w");
+      if (fd == 0) {
+	    perror(path);
+	    return;
+      }
+
+      fprintf(fd, "{\n");
+      json_items_(fd, "opcodes", "opcode", opcodes);
+      fprintf(fd, ",\n");
+      json_items_(fd, "functors", "class", functors);
+      fprintf(fd, ",\n");
+
+      fprintf(fd, "  \"scopes\": [");
+      for (size_t idx = 0 ;  idx < scopes.size() ;  idx += 1) {
+	    const scope_profile_s&cur = scope_counts[scope_list[idx].second];
+	    fprintf(fd, "%s\n    { \"scope\": ", idx? "," : "");
+	    json_string_(fd, scopes[idx].second);
+	    fprintf(fd, ", \"slices\": %lu, \"opcodes\": %lu, "
+		    "\"cpu_seconds\": %.6f }", cur.slices, cur.opcodes,
+		    (double)cur.cpu / CLOCKS_PER_SEC);
+      }
+      fprintf(fd, "\n  ],\n");
+
+      fprintf(fd, "  \"time_steps\": %lu,\n", profile_time_steps);
+      fprintf(fd, "  \"events\": [");
+      size_t edx = 0;
+      for (std::map<const char*,event_profile_s>::iterator cur = event_counts.begin()
+		 ; cur != event_counts.end() ; ++ cur, ++ edx ) {
+	    fprintf(fd, "%s\n    { \"type\": ", edx? "," : "");
+	    json_string_(fd, type_name_(cur->first));
+	    fprintf(fd, ", \"count\": %lu, \"max_per_step\": %lu }",
+		    cur->second.count, cur->second.step_max);
+      }
+      fprintf(fd, "\n  ]\n");
+      fprintf(fd, "}\n");
+      fclose(fd);
+}
@@ -0,0 +1,57 @@
+#ifndef __profile_H
+#define __profile_H
+/*
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA
+ */
+
+# include  <ctime>
+# include  <typeinfo>
+
+class vvp_net_t;
+struct vvp_code_s;
+struct __vpiScope;
+
+/*
+ * The execution profile is collected only when the -p flag is given
+ * to vvp. The thread and event loops test the profile_flag and call
+ * the profile_* functions below to count what they execute. At the end of
+ * the simulation, profile_report() prints a summary and writes the
+ * complete counts as JSON to the named file.
+ */
+extern bool profile_flag;
+
+  /* Count the execution of a single thread instruction. */
+extern void profile_opcode(const struct vvp_code_s*code);
+
+  /* Account for a thread run slice in the scope of the thread. */
+extern void profile_thread(struct __vpiScope*scope,
+			   unsigned long opcodes, clock_t cpu);
+
+  /* Remember a net of the design while it is compiled. When the
+     design is linked, profile_wrap_nets() puts a counting functor in
+     front of the functors of these nets, so that the values delivered
+     to them are counted without touching the propagation loops. */
+extern void profile_net(vvp_net_t*net);
+extern void profile_wrap_nets(void);
+
+  /* Count a scheduled event that is run, and mark the end of a time
+     step so that the per-step maximums can be kept. */
+extern void profile_event(const std::type_info&type);
+extern void profile_time_step(void);
+
+extern void profile_report(const char*path);
+
+#endif
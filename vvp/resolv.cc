@@ -72,14 +72,17 @@ void resolv_functor::recv_vec8(vvp_net_ptr_t port, const vvp_vector8_t&bit)
 
       vvp_vector8_t out (bit);
 
+	/* Drivers that are entirely HiZ do not affect the result, so
+	   skip them. If only one driver is active, then the result
+	   is just that driver and there is nothing to resolve. */
       for (unsigned idx = 0 ;  idx < 4 ;  idx += 1) {
 	    if (idx == pdx)
 		  continue;
 	    if (val_[idx].size() == 0)
 		  continue;
-	    if (out.size()==0)
+	    if (out.size()==0 || out.is_hiz())
 		  out = val_[idx];
-	    else
+	    else if (! val_[idx].is_hiz())
 		  out = resolve(out, val_[idx]);
       }
 
@@ -22,6 +22,7 @@
 # include  "vpi_priv.h"
 # include  "slab.h"
 # include  "compile.h"
+# include  "profile.h"
 # include  <new>
 # include  <typeinfo>
 # include  <csignal>
@@ -29,12 +30,15 @@
 # include  <cassert>
 
 # include  <iostream>
+# include  <map>
 
 unsigned long count_assign_events = 0;
 unsigned long count_gen_events = 0;
 unsigned long count_thread_events = 0;
   // Count the time events (A time cell created)
 unsigned long count_time_events = 0;
+  // Count the time cells that were parked in the time wheel overflow.
+unsigned long count_time_overflow = 0;
 
 
 
@@ -44,6 +48,9 @@ unsigned long count_time_events = 0;
  *
  * The event_time_s objects are one per time step. Each time step in
  * turn contains a list of event_s objects that are the actual events.
+ * The time of an event_time_s object is the absolute simulation time
+ * of the step, and the objects themselves are kept in a time queue
+ * (see below) that finds the cell for a given time.
  *
  * The event_s objects are base classes for the more specific sort of
  * event.
@@ -77,7 +84,7 @@ struct event_time_s {
 	    del_thr = 0;
 	    next = NULL;
       }
-      vvp_time64_t delay;
+      vvp_time64_t time;
 
       struct event_s*start;
       struct event_s*active;
@@ -113,9 +120,15 @@ struct vthread_event_s : public event_s {
       static void operator delete(void*);
 };
 
+  /* The event made by the latest schedule_vthread_wakeup(), until the
+     event runs. */
+static struct vthread_event_s*wakeup_event = 0;
+
 void vthread_event_s::run_run(void)
 {
       count_thread_events += 1;
+      if (this == wakeup_event)
+	    wakeup_event = 0;
       vthread_run(thr);
 }
 
@@ -479,12 +492,259 @@ inline void event_time_s::operator delete(void*ptr, size_t)
 unsigned long count_time_pool(void) { return event_time_heap.pool; }
 
 /*
- * This is the head of the list of pending events. This includes all
- * the events that have not been executed yet, and reaches into the
- * future.
+ * The pending time steps are kept in one of two time queues. The
+ * original queue is a sorted linked list of event_time_s cells. It is
+ * simple, but finding the cell for a time is linear in the number of
+ * pending time steps, so designs with many distinct future times
+ * (i.e. SDF annotated gate netlists) spend much of their time walking
+ * it.
+ *
+ * The default queue is a timing wheel. Each slot of the wheel holds
+ * the cell for exactly one time in the window [wheel_base,
+ * wheel_base+WHEEL_SIZE), so the cell for a time in the window is
+ * found by indexing. Times beyond the window are parked in an ordered
+ * overflow map and moved into the wheel as the window advances. A
+ * bitmap of the occupied slots makes finding the next time step a
+ * short scan of words.
+ *
+ * The schedule_set_time_wheel() function selects between the two. It
+ * must be called before anything is scheduled.
  */
+static bool sched_use_wheel = true;
+
+  // The linked list time queue.
 static struct event_time_s* sched_list = 0;
 
+static struct event_time_s* sched_list_find_(vvp_time64_t time)
+{
+      struct event_time_s*prev = 0;
+      struct event_time_s*ctim = sched_list;
+
+      while (ctim && (ctim->time < time)) {
+	    prev = ctim;
+	    ctim = ctim->next;
+      }
+
+      if (ctim && (ctim->time == time))
+	    return ctim;
+
+      struct event_time_s*tmp = new struct event_time_s;
+      tmp->time = time;
+      tmp->next = ctim;
+      if (prev)
+	    prev->next = tmp;
+      else
+	    sched_list = tmp;
+
+      return tmp;
+}
+
+  // The timing wheel time queue.
+static const unsigned WHEEL_BITS = 12;
+static const unsigned WHEEL_SIZE = 1 << WHEEL_BITS;
+static const unsigned WHEEL_MASK = WHEEL_SIZE - 1;
+static const unsigned WHEEL_WBITS = 8 * sizeof(unsigned long);
+static const unsigned WHEEL_WORDS = WHEEL_SIZE / WHEEL_WBITS;
+
+static struct event_time_s* wheel_slot[WHEEL_SIZE];
+static unsigned long wheel_used[WHEEL_WORDS];
+static unsigned wheel_count = 0;
+static vvp_time64_t wheel_base = 0;
+static std::map<vvp_time64_t,struct event_time_s*> wheel_overflow;
+
+static inline void wheel_insert_(struct event_time_s*ctim)
+{
+      unsigned slot = ctim->time & WHEEL_MASK;
+      assert(wheel_slot[slot] == 0);
+      wheel_slot[slot] = ctim;
+      wheel_used[slot/WHEEL_WBITS] |= 1UL << (slot%WHEEL_WBITS);
+      wheel_count += 1;
+}
+
+/*
+ * Move the cells that the window now covers from the overflow map
+ * into the wheel.
+ */
+static void wheel_refill_(void)
+{
+      while (! wheel_overflow.empty()) {
+	    std::map<vvp_time64_t,struct event_time_s*>::iterator cur
+		  = wheel_overflow.begin();
+	    if (cur->first - wheel_base >= WHEEL_SIZE)
+		  break;
+	    wheel_insert_(cur->second);
+	    wheel_overflow.erase(cur);
+      }
+}
+
+/*
+ * Move the window back so that it starts at the given time. This only
+ * happens if something is scheduled before the time step that the
+ * wheel last advanced to, so it is allowed to be slow.
+ */
+static void wheel_rebase_(vvp_time64_t time)
+{
+      assert(time < wheel_base);
+      wheel_base = time;
+      for (unsigned slot = 0 ; slot < WHEEL_SIZE ; slot += 1) {
+	    struct event_time_s*ctim = wheel_slot[slot];
+	    if (ctim == 0 || ctim->time - wheel_base < WHEEL_SIZE)
+		  continue;
+	    wheel_slot[slot] = 0;
+	    wheel_used[slot/WHEEL_WBITS] &= ~(1UL << (slot%WHEEL_WBITS));
+	    wheel_count -= 1;
+	    wheel_overflow[ctim->time] = ctim;
+	    count_time_overflow += 1;
+      }
+}
+
+static struct event_time_s* sched_wheel_find_(vvp_time64_t time)
+{
+      if (time < wheel_base)
+	    wheel_rebase_(time);
+
+      if (time - wheel_base < WHEEL_SIZE) {
+	    struct event_time_s*ctim = wheel_slot[time & WHEEL_MASK];
+	    if (ctim) {
+		  assert(ctim->time == time);
+		  return ctim;
+	    }
+
+	    ctim = new struct event_time_s;
+	    ctim->time = time;
+	    wheel_insert_(ctim);
+	    return ctim;
+      }
+
+      struct event_time_s*&ref = wheel_overflow[time];
+      if (ref == 0) {
+	    ref = new struct event_time_s;
+	    ref->time = time;
+	    count_time_overflow += 1;
+      }
+      return ref;
+}
+
+static struct event_time_s* sched_wheel_first_(void)
+{
+      if (wheel_count == 0) {
+	    if (wheel_overflow.empty())
+		  return 0;
+	    wheel_base = wheel_overflow.begin()->first;
+	    wheel_refill_();
+      }
+
+	/* Scan the occupied bitmap for the first slot at or after the
+	   base of the window. The window wraps around the end of the
+	   wheel, so the first word may be visited twice. */
+      unsigned slot = wheel_base & WHEEL_MASK;
+      unsigned word = slot / WHEEL_WBITS;
+      unsigned long bits = wheel_used[word] & (~0UL << (slot%WHEEL_WBITS));
+      for (unsigned cnt = 0 ; bits == 0 ; cnt += 1) {
+	    assert(cnt < WHEEL_WORDS);
+	    word = (word + 1) % WHEEL_WORDS;
+	    bits = wheel_used[word];
+      }
+
+      unsigned bit = 0;
+      while ((bits & (1UL << bit)) == 0)
+	    bit += 1;
+
+      struct event_time_s*ctim = wheel_slot[word*WHEEL_WBITS + bit];
+      assert(ctim && ctim->time >= wheel_base);
+      if (ctim->time != wheel_base) {
+	    wheel_base = ctim->time;
+	    wheel_refill_();
+      }
+
+      return ctim;
+}
+
+static void sched_wheel_remove_(struct event_time_s*ctim)
+{
+      unsigned slot = ctim->time & WHEEL_MASK;
+      assert(wheel_slot[slot] == ctim);
+      wheel_slot[slot] = 0;
+      wheel_used[slot/WHEEL_WBITS] &= ~(1UL << (slot%WHEEL_WBITS));
+      wheel_count -= 1;
+}
+
+/*
+ * Get the time step cell for the given absolute time, creating it if
+ * necessary.
+ */
+static inline struct event_time_s* sched_find_time_(vvp_time64_t time)
+{
+      if (sched_use_wheel)
+	    return sched_wheel_find_(time);
+      else
+	    return sched_list_find_(time);
+}
+
+/*
+ * Get the time step cell for the given absolute time, or nil if there
+ * is none. Unlike sched_find_time_, this never creates a cell.
+ */
+static struct event_time_s* sched_peek_time_(vvp_time64_t time)
+{
+      struct event_time_s*ctim;
+
+      if (! sched_use_wheel) {
+	    ctim = sched_list;
+	    while (ctim && (ctim->time < time))
+		  ctim = ctim->next;
+
+      } else if (time >= wheel_base && time - wheel_base < WHEEL_SIZE) {
+	    ctim = wheel_slot[time & WHEEL_MASK];
+
+      } else {
+	    std::map<vvp_time64_t,struct event_time_s*>::iterator cur
+		  = wheel_overflow.find(time);
+	    ctim = cur == wheel_overflow.end()? 0 : cur->second;
+      }
+
+      if (ctim && ctim->time == time)
+	    return ctim;
+      return 0;
+}
+
+/*
+ * Get the earliest pending time step, or nil if nothing is pending.
+ */
+static inline struct event_time_s* sched_first_time_(void)
+{
+      if (sched_use_wheel)
+	    return sched_wheel_first_();
+      else
+	    return sched_list;
+}
+
+/*
+ * Remove and delete the earliest pending time step. This is only
+ * called when all the events of the step have been run.
+ */
+static void sched_remove_first_(struct event_time_s*ctim)
+{
+      if (sched_use_wheel) {
+	    sched_wheel_remove_(ctim);
+      } else {
+	    assert(sched_list == ctim);
+	    sched_list = ctim->next;
+      }
+      delete ctim;
+}
+
+void schedule_set_time_wheel(bool flag)
+{
+      assert(sched_list == 0 && wheel_count == 0 && wheel_overflow.empty());
+      sched_use_wheel = flag;
+}
+
+bool schedule_time_wheel(void)
+{
+      return sched_use_wheel;
+}
+
 /*
  * This is a list of initialization events. The setup puts
  * initializations in this list so that they happen before the
@@ -559,11 +819,16 @@ static void schedule_init_event(struct event_s*cur)
       schedule_init_list = cur;
 }
 
+/*
+ * This is the time of the current time step. Event delays are
+ * relative to this time.
+ */
+static vvp_time64_t schedule_time;
+
 /*
  * This function does all the hard work of putting an event into the
- * event queue. The event delay is taken from the event structure
- * itself, and the structure is placed in the right place in the
- * queue.
+ * event queue. The time cell for the event is found in the time
+ * queue, and the event is placed in the right list of that cell.
  */
 typedef enum event_queue_e { SEQ_START, SEQ_ACTIVE, SEQ_NBASSIGN,
 			     SEQ_RWSYNC, SEQ_ROSYNC, DEL_THREAD } event_queue_t;
@@ -573,57 +838,7 @@ static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
 {
       cur->next = cur;
 
-      struct event_time_s*ctim = sched_list;
-
-      if (sched_list == 0) {
-	      /* Is the event_time list completely empty? Create the
-		 first event_time object. */
-	    ctim = new struct event_time_s;
-	    ctim->delay = delay;
-	    ctim->next  = 0;
-	    sched_list = ctim;
-
-      } else if (sched_list->delay > delay) {
-
-	      /* Am I looking for an event before the first event_time?
-		 If so, create a new event_time to go in front. */
-	    struct event_time_s*tmp = new struct event_time_s;
-	    tmp->delay = delay;
-	    tmp->next = ctim;
-	    ctim->delay -= delay;
-	    ctim = tmp;
-	    sched_list = ctim;
-
-      } else {
-	    struct event_time_s*prev = 0;
-
-	    while (ctim->next && (ctim->delay < delay)) {
-		  delay -= ctim->delay;
-		  prev = ctim;
-		  ctim = ctim->next;
-	    }
-
-	    if (ctim->delay > delay) {
-		  struct event_time_s*tmp = new struct event_time_s;
-		  tmp->delay = delay;
-		  tmp->next  = prev->next;
-		  prev->next = tmp;
-
-		  tmp->next->delay -= delay;
-		  ctim = tmp;
-
-	    } else if (ctim->delay == delay) {
-
-	    } else {
-		  assert(ctim->next == 0);
-		  struct event_time_s*tmp = new struct event_time_s;
-		  tmp->delay = delay - ctim->delay;
-		  tmp->next = 0;
-		  ctim->next = tmp;
-
-		  ctim = tmp;
-	    }
-      }
+      struct event_time_s*ctim = sched_find_time_(schedule_time + delay);
 
 	/* By this point, ctim is the event_time structure that is to
 	   receive the event at hand. Put the event in to the
@@ -635,9 +850,9 @@ static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
 	    if (ctim->start == 0) {
 		  ctim->start = cur;
 	    } else {
-		  cur->next = ctim->active->next;
-		  ctim->active->next = cur;
-		  ctim->active = cur;
+		  cur->next = ctim->start->next;
+		  ctim->start->next = cur;
+		  ctim->start = cur;
 	    }
 	    break;
 
@@ -705,12 +920,7 @@ static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
 
 static void schedule_event_push_(struct event_s*cur)
 {
-      if ((sched_list == 0) || (sched_list->delay > 0)) {
-	    schedule_event_(cur, 0, SEQ_ACTIVE);
-	    return;
-      }
-
-      struct event_time_s*ctim = sched_list;
+      struct event_time_s*ctim = sched_find_time_(schedule_time);
 
       if (ctim->active == 0) {
 	    cur->next = cur;
@@ -741,6 +951,25 @@ void schedule_vthread(vthread_t thr, vvp_time64_t delay, bool push_flag)
       }
 }
 
+void schedule_vthread_wakeup(vthread_t thr)
+{
+      struct vthread_event_s*cur = new vthread_event_s;
+
+      cur->thr = thr;
+      vthread_mark_scheduled(thr);
+      schedule_event_(cur, 0, SEQ_ACTIVE);
+      wakeup_event = cur;
+}
+
+bool schedule_vthread_wakeup_is_last(void)
+{
+      if (wakeup_event == 0)
+	    return false;
+
+      struct event_time_s*ctim = sched_peek_time_(schedule_time);
+      return ctim && ctim->active == wakeup_event;
+}
+
 void schedule_assign_vector(vvp_net_ptr_t ptr,
 			    unsigned base, unsigned vwid,
 			    const vvp_vector4_t&bit,
@@ -915,7 +1144,6 @@ void schedule_at_start_of_simtime(vvp_gen_event_t obj, vvp_time64_t delay)
       schedule_event_(cur, delay, SEQ_START);
 }
 
-static vvp_time64_t schedule_time;
 vvp_time64_t schedule_simtime(void)
 { return schedule_time; }
 
@@ -1010,7 +1238,7 @@ void schedule_simulate(void)
 	    vpi_mcd_printf(1, " ...run scheduler\n");
       }
 
-      if (schedule_runnable) while (sched_list) {
+      if (schedule_runnable) while (struct event_time_s*ctim = sched_first_time_()) {
 
 	    if (schedule_stopped_flag) {
 		  schedule_stopped_flag = false;
@@ -1020,22 +1248,21 @@ void schedule_simulate(void)
 		  continue;
 	    }
 
-	      /* ctim is the current time step. */
-	    struct event_time_s* ctim = sched_list;
-
-	      /* If the time is advancing, then first run the
-		 postponed sync events. Run them all. */
-	    if (ctim->delay > 0) {
+	      /* ctim is the current time step. If the time is
+		 advancing, then first run the postponed sync
+		 events. Run them all. */
+	    if (ctim->time > schedule_time) {
 
 		  if (!schedule_runnable) break;
-		  schedule_time += ctim->delay;
+		  schedule_time = ctim->time;
+		  if (profile_flag)
+			profile_time_step();
 		    /* When the design is being traced (we are emitting
 		     * file/line information) also print any time changes. */
 		  if (show_file_line) {
 			cerr << "Advancing to simulation time: "
 			     << schedule_time << endl;
 		  }
-		  ctim->delay = 0;
 
 		  vpiNextSimTime();
 		    // Process the cbAtStartOfSimTime callbacks.
@@ -1068,8 +1295,7 @@ void schedule_simulate(void)
 			     deletes threads as needed. */
 			if (ctim->active == 0) {
 			      run_rosync(ctim);
-			      sched_list = ctim->next;
-			      delete ctim;
+			      sched_remove_first_(ctim);
 			      continue;
 			}
 		  }
@@ -1091,6 +1317,9 @@ void schedule_simulate(void)
 		  schedule_single_step_flag = false;
 	    }
 
+	    if (profile_flag)
+		  profile_event(typeid(*cur));
+
 	    cur->run_run();
 
 	    delete (cur);
@@ -35,6 +35,17 @@
 extern void schedule_vthread(vthread_t thr, vvp_time64_t delay,
 			     bool push_flag =false);
 
+/*
+ * Schedule the thread list of a wakeup to run at the end of the active
+ * queue of the current time step, and remember its event until it
+ * runs. schedule_vthread_wakeup_is_last() returns true while that
+ * event is still the last one in the active queue. Threads added to
+ * its list then run just as they would from an event of their own,
+ * because nothing else is queued after it.
+ */
+extern void schedule_vthread_wakeup(vthread_t thr);
+extern bool schedule_vthread_wakeup_is_last(void);
+
 /*
  * Create an assignment event. The val passed here will be assigned to
  * the specified input when the delay times out. This is scheduled
@@ -151,9 +162,19 @@ struct vvp_gen_event_s
 extern void schedule_simulate(void);
 
 /*
- * Get the current absolute simulation time. This is not used
- * internally by the scheduler (which uses time differences instead)
- * but is used for printouts and stuff.
+ * Select the time queue that the scheduler uses to hold pending time
+ * steps. The default is a timing wheel, which finds the time step for
+ * an event in constant time. Passing false selects the simpler sorted
+ * list, which is mostly useful for comparing the two. This must be
+ * called before any events are scheduled.
+ */
+extern void schedule_set_time_wheel(bool flag);
+extern bool schedule_time_wheel(void);
+
+/*
+ * Get the current absolute simulation time. The scheduler keys its
+ * time queue on absolute times, and this is the time of the events
+ * that are now running.
  */
 extern vvp_time64_t schedule_simtime(void);
 
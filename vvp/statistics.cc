@@ -23,6 +23,13 @@
  * This is a count of the instruction opcodes that were created.
  */
 unsigned long count_opcodes = 0;
+  /* ... and the number that start a superinstruction. */
+unsigned long count_opcodes_fused = 0;
+  /* This is the number of opcodes dispatched by the threads. */
+unsigned long count_opcode_dispatches = 0;
+  /* ... and the number of instructions run by superinstructions
+     after their first. Add the two to get the instructions run. */
+unsigned long count_opcode_fused_steps = 0;
 
 unsigned long count_functors = 0;
 unsigned long count_functors_logic = 0;
@@ -35,5 +42,17 @@ unsigned long count_vpi_nets = 0;
 
 unsigned long count_vpi_scopes = 0;
 
+  /* These count the heap allocated vvp_vector4_t bit arrays, the
+     vector copies that shared an existing array instead, and the
+     shared arrays that were copied so that a vector could change. */
+unsigned long count_vector4_allocs = 0;
+unsigned long count_vector4_shared = 0;
+unsigned long count_vector4_unshared = 0;
+
+  /* These count the output events that the delay functors scheduled,
+     and the ones that were cancelled as pulses by a later input. */
+unsigned long count_delay_scheduled = 0;
+unsigned long count_delay_cancelled = 0;
+
 size_t size_opcodes = 0;
 
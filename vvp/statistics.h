@@ -27,6 +27,9 @@
 #endif
 
 extern unsigned long count_opcodes;
+extern unsigned long count_opcodes_fused;
+extern unsigned long count_opcode_dispatches;
+extern unsigned long count_opcode_fused_steps;
 extern unsigned long count_functors;
 extern unsigned long count_functors_logic;
 extern unsigned long count_functors_bufif;
@@ -37,6 +40,13 @@ extern unsigned long count_vvp_nets;
 extern unsigned long count_vpi_nets;
 extern unsigned long count_vpi_scopes;
 
+extern unsigned long count_vector4_allocs;
+extern unsigned long count_vector4_shared;
+extern unsigned long count_vector4_unshared;
+
+extern unsigned long count_delay_scheduled;
+extern unsigned long count_delay_cancelled;
+
 extern unsigned long count_net_arrays;
 extern unsigned long count_net_array_words;
 extern unsigned long count_var_arrays;
@@ -47,6 +57,7 @@ extern unsigned long count_real_array_words;
 
 extern unsigned long count_time_events;
 extern unsigned long count_time_pool(void);
+extern unsigned long count_time_overflow;
 
 extern unsigned long count_assign_events;
 extern unsigned long count_assign4_pool(void);
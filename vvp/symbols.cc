@@ -55,318 +55,120 @@ char*symbol_table_s::key_strdup_(const char*str)
 }
 
 /*
- * This is a B-Tree data structure, where there are nodes and
- * leaves.
- *
- * Nodes have a bunch of pointers to children. Each child pointer has
- * associated with it a key that is the largest key referenced by that
- * child. So, if the key being searched for has a value <= the first
- * key of a node, then the value is in the first child.
- *
- * leaves have a sorted table of key-value pairs. The search can use a
- * simple binary search to find an item. Each key represents an item.
+ * The table itself is an open addressed hash table with linear
+ * probing. Each entry keeps the full hash of its key, so that a probe
+ * only needs to compare strings when the hashes match. The table size
+ * is always a power of 2, and the table is doubled when it gets 3/4
+ * full, so probe sequences stay short.
  */
 
-const unsigned leaf_width = 254;
-const unsigned node_width = 508;
+const unsigned initial_table_size = 256;
 
-struct tree_data_ {
+struct symbol_entry_ {
       char*key;
+      unsigned hash;
       symbol_value_t val;
 };
 
-struct tree_node_ {
-      bool leaf_flag;
-      unsigned count;
-      struct tree_node_*parent;
-
-      union {
-	    struct tree_data_ leaf[leaf_width];
-	    struct tree_node_ *child[node_width];
-      };
-
-};
-
-static inline char* node_last_key(struct tree_node_*node)
+/*
+ * This is the FNV-1a hash of the key string.
+ */
+static inline unsigned hash_key_(const char*key)
 {
-      while (node->leaf_flag == false)
-	    node = node->child[node->count-1];
-
-      return node->leaf[node->count-1].key;
+      unsigned hash = 2166136261U;
+      for (const unsigned char*cp = (const unsigned char*)key ; *cp ; cp += 1) {
+	    hash ^= *cp;
+	    hash *= 16777619U;
+      }
+      return hash;
 }
 
 /*
- * Allocate a new symbol table means creating the table structure and
- * a root node, and initializing the pointers and members of the root
- * node.
+ * Allocate a new symbol table means creating an empty hash table and
+ * the first chunk of key strings.
  */
 symbol_table_s::symbol_table_s()
 {
-      root = new struct tree_node_;
-      root->leaf_flag = false;
-      root->count = 0;
-      root->parent = 0;
+      table_size_ = initial_table_size;
+      table_used_ = 0;
+      table_ = new struct symbol_entry_[table_size_];
+      for (unsigned idx = 0 ;  idx < table_size_ ;  idx += 1)
+	    table_[idx].key = 0;
 
       str_chunk = new key_strings;
       str_chunk->next = 0;
       str_used = 0;
 }
 
-static void delete_symbol_node(struct tree_node_*cur)
-{
-      if (! cur->leaf_flag) {
-	    for (unsigned idx = 0 ;  idx < cur->count ;  idx += 1)
-		  delete_symbol_node(cur->child[idx]);
-      }
-
-      delete cur;
-}
-
-/* Do as split_leaf_ does, but for nodes. */
-static void split_node_(struct tree_node_*cur)
-{
-	unsigned int idx, idx1, idx2, tmp;
-	struct tree_node_ *new_node;
-
-	assert(!cur->leaf_flag);
-	if (cur->parent)  assert(! cur->parent->leaf_flag);
-
-	while (cur->count == node_width)
-	{
-		/* Create a new node to hold half the data from cur. */
-		new_node = new struct tree_node_;
-		new_node->leaf_flag = false;
-		new_node->count = cur->count / 2;
-		if (cur->parent)
-			/* cur is not root; new_node becomes sibling. */
-			new_node->parent = cur->parent;
-
-		/* Move the last half of the data from the end of the old node
-		   to the beginning of the new node. At the same time, reduce
-		   the size of the old node. */
-		idx1 = new_node->count;
-		idx2 = cur->count;
-		while (idx1 > 0) {
-		      idx1 -= 1;
-		      idx2 -= 1;
-		      new_node->child[idx1] = cur->child[idx2];
-		      new_node->child[idx1]->parent = new_node;
-		      cur->count -= 1;
-		}
-
-		assert(new_node->count > 0);
-		assert(cur->count > 0);
-
-		if (cur->parent == 0) {
-			/* cur is root. Move first half of children to
-			   another new node, and put the two new nodes
-			   in cur. The plan here is to make cur into
-			   the new root and split its contents into 2
-			   children. */
-
-		      new_node->parent = cur;
-		      struct tree_node_*new2_node = new struct tree_node_;
-		      new2_node->leaf_flag = false;
-		      new2_node->count = cur->count;
-		      new2_node->parent = cur;
-		      for (idx = 0; idx < cur->count; idx += 1) {
-			    new2_node->child[idx] = cur->child[idx];
-			    new2_node->child[idx]->parent = new2_node;
-		      }
-		      cur->child[0] = new2_node;
-		      cur->child[1] = new_node;
-		      cur->count = 2;
-			/* no more ancestors, stop the while loop */
-		      break;
-		}
-
-		/* cur is not root. hook new_node to cur->parent. */
-		idx = 0;
-		while (cur->parent->child[idx] != cur) {
-			assert(idx < cur->parent->count);
-			idx += 1;
-		}
-
-		idx += 1;
-
-		for (tmp = cur->parent->count ;  tmp > idx ;  tmp -= 1)
-			cur->parent->child[tmp] = cur->parent->child[tmp-1];
-
-		cur->parent->child[idx] = new_node;
-		cur->parent->count += 1;
-
-		/* check the ancestor */
-		cur = cur->parent;
-	}
-}
-
 /*
- * This function takes a leaf node and splits in into two. Move half
- * the leaf keys into the new node, and add the new leaf into the
- * parent node.
+ * Double the size of the hash table and move all the entries from the
+ * old table to the new. The key strings themselves stay where they
+ * are, and the saved hashes mean there is no need to rehash them.
  */
-static struct tree_node_* split_leaf_(struct tree_node_*cur)
+void symbol_table_s::grow_table_()
 {
-      assert(cur->leaf_flag);
-      assert(cur->parent);
-      assert(! cur->parent->leaf_flag);
+      struct symbol_entry_*old_table = table_;
+      unsigned old_size = table_size_;
 
-	/* Create a new leaf to hold half the data from the old leaf. */
-      struct tree_node_*new_leaf = new struct tree_node_;
-      new_leaf->leaf_flag = true;
-      new_leaf->count = cur->count / 2;
-      new_leaf->parent = cur->parent;
+      table_size_ = 2 * old_size;
+      table_ = new struct symbol_entry_[table_size_];
+      for (unsigned idx = 0 ;  idx < table_size_ ;  idx += 1)
+	    table_[idx].key = 0;
 
-	/* Move the last half of the data from the end of the old leaf
-	   to the beginning of the new leaf. At the same time, reduce
-	   the size of the old leaf. */
-      unsigned idx1 = new_leaf->count;
-      unsigned idx2 = cur->count;
-      while (idx1 > 0) {
-	    idx1 -= 1;
-	    idx2 -= 1;
-	    new_leaf->leaf[idx1] = cur->leaf[idx2];
-	    cur->count -= 1;
-      }
+      unsigned mask = table_size_ - 1;
+      for (unsigned idx = 0 ;  idx < old_size ;  idx += 1) {
+	    if (old_table[idx].key == 0)
+		  continue;
 
-      assert(new_leaf->count > 0);
-      assert(cur->count > 0);
+	    unsigned ptr = old_table[idx].hash & mask;
+	    while (table_[ptr].key != 0)
+		  ptr = (ptr + 1) & mask;
 
-      unsigned idx = 0;
-      while (cur->parent->child[idx] != cur) {
-	    assert(idx < cur->parent->count);
-	    idx += 1;
+	    table_[ptr] = old_table[idx];
       }
 
-      idx += 1;
-
-      for (unsigned tmp = cur->parent->count ;  tmp > idx ;  tmp -= 1)
-	    cur->parent->child[tmp] = cur->parent->child[tmp-1];
-
-      cur->parent->child[idx] = new_leaf;
-      cur->parent->count += 1;
-
-      if (cur->parent->count == node_width)
-	    split_node_(cur->parent);
-
-      return new_leaf;
+      delete[]old_table;
 }
 
-
 /*
- * This function searches tree recursively for the key. If the value
- * is not found (and we are at a leaf) then set the key with the given
- * value. If the key is found, set the value only if the force_flag is
- * true.
+ * This function searches the table for the key. If the key is not
+ * found, then add it to the table with the given value. If the key is
+ * found, set the value only if the force_flag is true.
  */
-
-symbol_value_t symbol_table_s::find_value_(struct tree_node_*cur,
-					   const char*key, symbol_value_t val,
+symbol_value_t symbol_table_s::find_value_(const char*key, symbol_value_t val,
 					   bool force_flag)
 {
-      if (cur->leaf_flag) {
-
-	    unsigned idx = 0;
-	    for (;;) {
-		    /* If we run out of keys in the leaf, then add
-		       this at the end of the leaf. */
-		  if (idx == cur->count) {
-			cur->leaf[idx].key = key_strdup_(key);
-			cur->leaf[idx].val = val;
-			cur->count += 1;
-			if (cur->count == leaf_width)
-			      split_leaf_(cur);
-
-			return val;
-		  }
-
-		  int rc = strcmp(key, cur->leaf[idx].key);
-
-		    /* If we found the key already in the table, then
-		       set the new value and break. */
-		  if (rc == 0) {
-			if (force_flag)
-			      cur->leaf[idx].val = val;
-			return cur->leaf[idx].val;
-		  }
-
-		    /* If this key goes before the current key, then
-		       push all the following entries back and add
-		       this key here. */
-		  if (rc < 0) {
-			for (unsigned tmp = cur->count; tmp > idx; tmp -= 1)
-			      cur->leaf[tmp] = cur->leaf[tmp-1];
-
-			cur->leaf[idx].key = key_strdup_(key);
-			cur->leaf[idx].val = val;
-			cur->count += 1;
-			if (cur->count == leaf_width)
-			      split_leaf_(cur);
-
-			return val;
-		  }
-
-		  idx += 1;
+      unsigned hash = hash_key_(key);
+      unsigned mask = table_size_ - 1;
+
+      unsigned ptr = hash & mask;
+      while (table_[ptr].key != 0) {
+	    struct symbol_entry_*cur = table_ + ptr;
+	    if (cur->hash == hash && strcmp(key, cur->key) == 0) {
+		  if (force_flag)
+			cur->val = val;
+		  return cur->val;
 	    }
 
-      } else {
-	      /* Do a binary search within the inner node. */
-	    unsigned min = 0;
-	    unsigned max = cur->count;
-	    unsigned idx = max/2;
-	    for (;;) {
-		  int rc = strcmp(key, node_last_key(cur->child[idx]));
-		  if (rc == 0) {
-			return find_value_(cur->child[idx],
-					   key, val, force_flag);
-		  }
+	    ptr = (ptr + 1) & mask;
+      }
 
-		  if (rc > 0) {
-			min = idx + 1;
-			if (min == cur->count)
-			      return find_value_(cur->child[idx],
-						 key, val, force_flag);
-			if (min == max)
-			      return find_value_(cur->child[max],
-						 key, val, force_flag);
+	/* The key is not in the table, so add it in the empty slot
+	   that ended the search. */
+      table_[ptr].key = key_strdup_(key);
+      table_[ptr].hash = hash;
+      table_[ptr].val = val;
+      table_used_ += 1;
 
-			idx = min + (max-min)/2;
+      if (4*table_used_ >= 3*table_size_)
+	    grow_table_();
 
-		  } else  {
-			max = idx;
-			if (idx == min)
-			      return find_value_(cur->child[idx],
-						 key, val, force_flag);
-			idx = min + (max-min)/2;
-		  }
-	    }
-      }
-
-      assert(0);
-      { symbol_value_t tmp;
-        tmp.num = 0;
-        return tmp;
-      }
+      return val;
 }
 
 void symbol_table_s::sym_set_value(const char*key, symbol_value_t val)
 {
-      if (root->count == 0) {
-	      /* Handle the special case that this is the very first
-		 value in the symbol table. Create the first leaf node
-		 and initialize the pointers. */
-	    struct tree_node_*cur = new struct tree_node_;
-	    cur->leaf_flag = true;
-	    cur->parent = root;
-	    cur->count = 1;
-	    cur->leaf[0].key = key_strdup_(key);
-	    cur->leaf[0].val = val;
-
-	    root->count = 1;
-	    root->child[0] = cur;
-      } else {
-	    find_value_(root, key, val, true);
-      }
+      find_value_(key, val, true);
 }
 
 symbol_value_t symbol_table_s::sym_get_value(const char*key)
@@ -374,28 +176,12 @@ symbol_value_t symbol_table_s::sym_get_value(const char*key)
       symbol_value_t def;
       def.num = 0;
 
-      if (root->count == 0) {
-	      /* Handle the special case that this is the very first
-		 value in the symbol table. Create the first leaf node
-		 and initialize the pointers. */
-	    struct tree_node_*cur = new struct tree_node_;
-	    cur->leaf_flag = true;
-	    cur->parent = root;
-	    cur->count = 1;
-	    cur->leaf[0].key = key_strdup_(key);
-	    cur->leaf[0].val = def;
-
-	    root->count = 1;
-	    root->child[0] = cur;
-	    return cur->leaf[0].val;
-      } else {
-	    return find_value_(root, key, def, false);
-      }
+      return find_value_(key, def, false);
 }
 
 symbol_table_s::~symbol_table_s()
 {
-      delete_symbol_node(root);
+      delete[]table_;
       while (str_chunk) {
 	    key_strings*tmp = str_chunk;
 	    str_chunk = tmp->next;
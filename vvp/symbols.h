@@ -69,13 +69,15 @@ class symbol_table_s {
       symbol_value_t sym_get_value(const char*key);
 
     private:
-      struct tree_node_*root;
+      struct symbol_entry_*table_;
+      unsigned table_size_;
+      unsigned table_used_;
       struct key_strings*str_chunk;
       unsigned str_used;
 
-      symbol_value_t find_value_(struct tree_node_*cur,
-				 const char*key, symbol_value_t val,
+      symbol_value_t find_value_(const char*key, symbol_value_t val,
 				 bool force_flag);
+      void grow_table_();
       char*key_strdup_(const char*str);
 };
 
@@ -82,6 +82,61 @@ ostream& operator <<(ostream&o, const struct udp_levels_table&table)
       return o;
 }
 
+/*
+ * The compiled lookup tables are indexed by the input levels packed
+ * 2 bits per port: 0 for a 0, 1 for a 1 and 2 for an x or z. These
+ * are the limits on the number of ports that get a table. A
+ * sequential table has (4**(ports+1))*ports*4 entries.
+ */
+static const unsigned UDP_COMB_TABLE_PORTS = 8;
+static const unsigned UDP_SEQ_TABLE_PORTS = 5;
+
+/*
+ * Spread the low 8 bits of the value so that each bit is followed by
+ * a zero bit.
+ */
+static inline unsigned long udp_spread_bits(unsigned long val)
+{
+      val = (val | (val << 4)) & 0x0f0fUL;
+      val = (val | (val << 2)) & 0x3333UL;
+      val = (val | (val << 1)) & 0x5555UL;
+      return val;
+}
+
+static inline unsigned long udp_pack_levels(const udp_levels_table&cur)
+{
+      return udp_spread_bits(cur.mask1) | (udp_spread_bits(cur.maskx) << 1);
+}
+
+/*
+ * Make the levels table for a packed index. This returns false if the
+ * index holds the unused code 3 for any of the ports.
+ */
+static bool udp_unpack_levels(udp_levels_table&cur, unsigned long idx,
+			      unsigned ports)
+{
+      cur.mask0 = 0;
+      cur.mask1 = 0;
+      cur.maskx = 0;
+      for (unsigned pp = 0 ;  pp < ports ;  pp += 1) {
+	    unsigned long mask_bit = 1UL << pp;
+	    switch ((idx >> 2*pp) & 3) {
+		case 0:
+		  cur.mask0 |= mask_bit;
+		  break;
+		case 1:
+		  cur.mask1 |= mask_bit;
+		  break;
+		case 2:
+		  cur.maskx |= mask_bit;
+		  break;
+		default:
+		  return false;
+	    }
+      }
+      return true;
+}
+
 vvp_udp_s::vvp_udp_s(char*label, unsigned ports, vvp_bit4_t init, bool type)
 : ports_(ports), init_(init), seq_(type)
 {
@@ -124,12 +179,14 @@ vvp_udp_comb_s::vvp_udp_comb_s(char*label, char*name, unsigned ports)
       levels1_ = 0;
       nlevels0_ = 0;
       nlevels1_ = 0;
+      table_ = 0;
 }
 
 vvp_udp_comb_s::~vvp_udp_comb_s()
 {
       delete[] levels0_;
       delete[] levels1_;
+      delete[] table_;
 }
 
 /*
@@ -187,9 +244,34 @@ vvp_bit4_t vvp_udp_comb_s::calculate_output(const udp_levels_table&cur,
 					    const udp_levels_table&,
 					    vvp_bit4_t)
 {
+      if (table_)
+	    return (vvp_bit4_t) table_[udp_pack_levels(cur)];
+
       return test_levels(cur);
 }
 
+/*
+ * Evaluate the rows for every possible input vector and save the
+ * results in a table. The entries for indices that contain the
+ * unused code 3 are never looked up.
+ */
+void vvp_udp_comb_s::compile_lookup_()
+{
+      if (port_count() > UDP_COMB_TABLE_PORTS)
+	    return;
+
+      unsigned long size = 1UL << 2*port_count();
+      table_ = new unsigned char[size];
+
+      for (unsigned long idx = 0 ;  idx < size ;  idx += 1) {
+	    udp_levels_table cur;
+	    if (udp_unpack_levels(cur, idx, port_count()))
+		  table_[idx] = test_levels(cur);
+	    else
+		  table_[idx] = BIT4_X;
+      }
+}
+
 static void or_based_on_char(udp_levels_table&cur, char flag,
 			     unsigned long mask_bit)
 {
@@ -293,6 +375,8 @@ void vvp_udp_comb_s::compile_table(char**tab)
 
       assert(nrows0 == nlevels0_);
       assert(nrows1 == nlevels1_);
+
+      compile_lookup_();
 }
 
 vvp_udp_seq_s::vvp_udp_seq_s(char*label, char*name,
@@ -317,6 +401,8 @@ vvp_udp_seq_s::vvp_udp_seq_s(char*label, char*name,
       nedges0_ = 0;
       nedges1_ = 0;
       nedgesL_ = 0;
+
+      table_ = 0;
 }
 
 vvp_udp_seq_s::~vvp_udp_seq_s()
@@ -328,6 +414,7 @@ vvp_udp_seq_s::~vvp_udp_seq_s()
       delete[] edges0_;
       delete[] edges1_;
       delete[] edgesL_;
+      delete[] table_;
 }
 
 void edge_based_on_char(struct udp_edges_table&cur, char chr, unsigned pos)
@@ -674,6 +761,7 @@ void vvp_udp_seq_s::compile_table(char**tab)
       assert(idx_edg1 == nedges1_);
       assert(idx_edgL == nedgesL_);
 
+      compile_lookup_();
 }
 
 bool operator == (const udp_levels_table&a, const udp_levels_table&b)
@@ -694,6 +782,47 @@ vvp_bit4_t vvp_udp_seq_s::calculate_output(const udp_levels_table&cur,
       if (cur == prev)
 	    return cur_out;
 
+      if (table_ == 0)
+	    return test_rows_(cur, prev, cur_out);
+
+      unsigned long edge_mask = (cur.mask0 ^ prev.mask0)
+	                      | (cur.mask1 ^ prev.mask1)
+	                      | (cur.maskx ^ prev.maskx);
+
+	/* The table only covers a change of a single input. */
+      if (edge_mask & (edge_mask-1))
+	    return test_rows_(cur, prev, cur_out);
+
+      unsigned edge_position = 0;
+      while ((edge_mask&1) == 0) {
+	    edge_mask >>= 1;
+	    edge_position += 1;
+      }
+
+      unsigned long out_code;
+      switch (cur_out) {
+	  case BIT4_0:
+	    out_code = 0;
+	    break;
+	  case BIT4_1:
+	    out_code = 1;
+	    break;
+	  default:
+	    out_code = 2;
+	    break;
+      }
+
+      unsigned long lev = udp_pack_levels(cur) | (out_code << 2*port_count());
+      unsigned long prev_code = (udp_pack_levels(prev) >> 2*edge_position) & 3;
+
+      return (vvp_bit4_t) table_[((lev*port_count() + edge_position) << 2)
+				 | prev_code];
+}
+
+vvp_bit4_t vvp_udp_seq_s::test_rows_(const udp_levels_table&cur,
+				     const udp_levels_table&prev,
+				     vvp_bit4_t cur_out)
+{
       udp_levels_table cur_tmp = cur;
 
       unsigned long mask_out = 1UL << port_count();
@@ -717,6 +846,59 @@ vvp_bit4_t vvp_udp_seq_s::calculate_output(const udp_levels_table&cur,
       return lev;
 }
 
+/*
+ * Evaluate the rows for every current input and output vector, and
+ * every single input change that can lead to it. The entries where
+ * the previous value is the same as the current value, or that have
+ * the unused code 3, are never looked up.
+ */
+void vvp_udp_seq_s::compile_lookup_()
+{
+      if (port_count() > UDP_SEQ_TABLE_PORTS)
+	    return;
+
+      unsigned long nlev = 1UL << 2*(port_count()+1);
+      table_ = new unsigned char[nlev * port_count() * 4];
+
+      for (unsigned long lev = 0 ;  lev < nlev ;  lev += 1) {
+	    udp_levels_table cur;
+	    bool valid = udp_unpack_levels(cur, lev, port_count());
+
+	    vvp_bit4_t cur_out;
+	    switch (lev >> 2*port_count()) {
+		case 0:
+		  cur_out = BIT4_0;
+		  break;
+		case 1:
+		  cur_out = BIT4_1;
+		  break;
+		case 2:
+		  cur_out = BIT4_X;
+		  break;
+		default:
+		  cur_out = BIT4_X;
+		  valid = false;
+		  break;
+	    }
+
+	    for (unsigned pp = 0 ;  pp < port_count() ;  pp += 1) {
+		  unsigned long cur_code = (lev >> 2*pp) & 3;
+		  for (unsigned long code = 0 ;  code < 4 ;  code += 1) {
+			unsigned char&ent = table_[((lev*port_count() + pp) << 2)
+						   | code];
+			ent = BIT4_X;
+			if (!valid || code == 3 || code == cur_code)
+			      continue;
+
+			udp_levels_table prev;
+			udp_unpack_levels(prev, (lev & ~(3UL << 2*pp))
+					  | (code << 2*pp), port_count());
+			ent = test_rows_(cur, prev, cur_out);
+		  }
+	    }
+      }
+}
+
 /*
  * This function tests the levels of the input with the additional
  * check match for the current output. It uses this to calculate a
@@ -100,6 +100,11 @@ struct vvp_udp_s {
  *   ?  -- 0, x or 1
  *
  * Only 0, 1 and x characters are allowed in the output position.
+ *
+ * When the device has few enough inputs, compile_table also builds a
+ * direct lookup table with an entry for every possible input vector,
+ * so that calculate_output does not need to scan the rows. The table
+ * is indexed by the inputs packed 2 bits per port (0, 1 or x).
  */
 
 struct udp_levels_table {
@@ -131,6 +136,11 @@ class vvp_udp_comb_s : public vvp_udp_s {
       struct udp_levels_table*levels0_;
       struct udp_levels_table*levels1_;
       unsigned nlevels0_, nlevels1_;
+
+      void compile_lookup_();
+
+	// Compiled lookup table, or nil if there are too many ports.
+      unsigned char*table_;
 };
 
 /*
@@ -166,6 +176,12 @@ class vvp_udp_comb_s : public vvp_udp_s {
  * position, and the edge_position the bit that has shifted. In the
  * edge case, the mask* members give the final position and the
  * edge_mask* bits the initial position of the bit.
+ *
+ * As with the combinational device, small sequential devices get a
+ * compiled lookup table. Since the inputs change one at a time, the
+ * table is indexed by the packed current inputs and output, the
+ * position of the input that changed and the previous value of that
+ * input. Any other kind of change uses the rows.
  */
 struct udp_edges_table {
       unsigned long edge_position : 8;
@@ -210,6 +226,13 @@ class vvp_udp_seq_s : public vvp_udp_s {
       struct udp_edges_table*edgesL_;
       unsigned nedges0_, nedges1_, nedgesL_;
 
+      vvp_bit4_t test_rows_(const udp_levels_table&cur,
+			    const udp_levels_table&prev,
+			    vvp_bit4_t cur_out);
+      void compile_lookup_();
+
+	// Compiled lookup table, or nil if there are too many ports.
+      unsigned char*table_;
 };
 
 /*
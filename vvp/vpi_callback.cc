@@ -34,6 +34,8 @@
 # include  <cstdio>
 # include  <cassert>
 # include  <cstdlib>
+# include  <cstring>
+# include  <vector>
 
 /*
 * The vpi_free_object() call to a callback doesn't actually delete
@@ -85,6 +87,9 @@ struct sync_cb  : public vvp_gen_event_s {
       virtual void run_run();
 };
 
+static void queue_value_change_batch(struct __vpiCallback*cur);
+static void unqueue_value_change_batch(struct __vpiCallback*cur);
+
 
 struct __vpiCallback* new_vpi_callback()
 {
@@ -94,6 +99,7 @@ struct __vpiCallback* new_vpi_callback()
 
       obj->base.vpi_type = &callback_rt;
       obj->cb_sync = 0;
+      obj->batch_queued = false;
       obj->next    = 0;
       return obj;
 }
@@ -177,6 +183,14 @@ static struct __vpiCallback* make_value_change(p_cb_data data)
 	    break;
 
 	  case vpiMemory:
+	      /* A batch can only report a whole array once, so it
+		 can not say which of the words changed. */
+	    if (data->reason == _cbValueChangeBatch) {
+		  fprintf(stderr, "vpi error: cannot place a batched "
+			  "value change callback on a memory.\n");
+		  delete obj;
+		  return 0;
+	    }
 	    vpip_array_change(obj, data->obj);
 	    break;
 
@@ -435,6 +449,7 @@ vpiHandle vpi_register_cb(p_cb_data data)
       switch (data->reason) {
 
 	  case cbValueChange:
+	  case _cbValueChangeBatch:
 	    obj = make_value_change(data);
 	    break;
 
@@ -485,15 +500,14 @@ PLI_INT32 vpi_remove_cb(vpiHandle ref)
       struct __vpiCallback*obj = (struct __vpiCallback*)ref;
       obj->cb_data.cb_rtn = 0;
 
+      if (obj->batch_queued)
+	    unqueue_value_change_batch(obj);
+
       return 1;
 }
 
-void callback_execute(struct __vpiCallback*cur)
+static void set_callback_time(struct __vpiCallback*cur)
 {
-      const vpi_mode_t save_mode = vpi_mode_flag;
-      vpi_mode_flag = VPI_MODE_RWSYNC;
-
-      assert(cur->cb_data.cb_rtn);
       switch (cur->cb_data.time->type) {
 	  case vpiSimTime:
 	    vpip_time_to_timestruct(cur->cb_data.time, schedule_simtime());
@@ -513,16 +527,209 @@ void callback_execute(struct __vpiCallback*cur)
 	    assert(0);
 	    break;
       }
+}
+
+void callback_execute(struct __vpiCallback*cur)
+{
+      if (cur->cb_data.reason == _cbValueChangeBatch) {
+	    queue_value_change_batch(cur);
+	    return;
+      }
+
+      const vpi_mode_t save_mode = vpi_mode_flag;
+      vpi_mode_flag = VPI_MODE_RWSYNC;
+
+      assert(cur->cb_data.cb_rtn);
+      set_callback_time(cur);
       (cur->cb_data.cb_rtn)(&cur->cb_data);
 
       vpi_mode_flag = save_mode;
 }
 
+/*
+ * Batched value change callbacks are queued when their object
+ * changes, and the first one queued in a time step schedules the
+ * value_change_batch event in the read-only synch region. That event
+ * reads the values and calls each cb_rtn once with all of its
+ * changed objects. A callback is queued at most once per time step.
+ */
+struct value_change_batch_s  : public vvp_gen_event_s {
+      value_change_batch_s() : scheduled(false) { }
+      ~value_change_batch_s() { }
+
+      virtual void run_run();
+
+      std::vector<struct __vpiCallback*> queue;
+      bool scheduled;
+
+    private:
+      void deliver_(std::vector<struct __vpiCallback*>&list);
+      void save_value_(struct __vpiCallback*cur);
+
+	// Storage for the values that are returned by reference.
+      std::vector<char> value_buf_;
+      std::vector<std::pair<struct __vpiCallback*,size_t> > value_fix_;
+      std::vector<struct t_cb_data> entries_;
+};
+
+static value_change_batch_s value_change_batch;
+
+static void queue_value_change_batch(struct __vpiCallback*cur)
+{
+      if (cur->batch_queued)
+	    return;
+
+      cur->batch_queued = true;
+      value_change_batch.queue.push_back(cur);
+
+      if (! value_change_batch.scheduled) {
+	    value_change_batch.scheduled = true;
+	    schedule_generic(&value_change_batch, 0, true, true);
+      }
+}
+
+static void unqueue_value_change_batch(struct __vpiCallback*cur)
+{
+      std::vector<struct __vpiCallback*>&queue = value_change_batch.queue;
+      for (size_t idx = 0 ;  idx < queue.size() ;  idx += 1) {
+	    if (queue[idx] == cur) {
+		  queue.erase(queue.begin() + idx);
+		  break;
+	    }
+      }
+      cur->batch_queued = false;
+}
+
+/*
+ * The string and vector values that vpi_get_value returns point into
+ * a buffer that the next call reuses, so copy them aside. The
+ * pointers are fixed up after all the values of the batch are read,
+ * since the buffer may move as it grows.
+ */
+void value_change_batch_s::save_value_(struct __vpiCallback*cur)
+{
+      struct t_vpi_value*vp = &cur->cb_value;
+      const char*src = 0;
+      size_t len = 0;
+
+      switch (vp->format) {
+	  case vpiBinStrVal:
+	  case vpiOctStrVal:
+	  case vpiDecStrVal:
+	  case vpiHexStrVal:
+	  case vpiStringVal:
+	    src = vp->value.str;
+	    len = strlen(vp->value.str) + 1;
+	    break;
+	  case vpiVectorVal:
+	    src = (const char*)vp->value.vector;
+	    len = (vpi_get(vpiSize, cur->cb_data.obj) + 31) / 32
+		  * sizeof(s_vpi_vecval);
+	    break;
+	  case vpiStrengthVal:
+	    src = (const char*)vp->value.strength;
+	    len = vpi_get(vpiSize, cur->cb_data.obj) * sizeof(s_vpi_strengthval);
+	    break;
+	  case vpiTimeVal:
+	    src = (const char*)vp->value.time;
+	    len = sizeof(s_vpi_time);
+	    break;
+	  default:
+	    return;
+      }
+
+	/* Keep the values aligned for the structure types. */
+      size_t base = (value_buf_.size() + sizeof(double) - 1)
+	            / sizeof(double) * sizeof(double);
+      value_buf_.resize(base + len);
+      memcpy(&value_buf_[base], src, len);
+      value_fix_.push_back(std::make_pair(cur, base));
+}
+
+void value_change_batch_s::deliver_(std::vector<struct __vpiCallback*>&list)
+{
+      value_buf_.clear();
+      value_fix_.clear();
+      entries_.clear();
+
+      for (size_t idx = 0 ;  idx < list.size() ;  idx += 1) {
+	    struct __vpiCallback*cur = list[idx];
+
+	    set_callback_time(cur);
+	    if (cur->cb_value.format != vpiSuppressVal
+		&& cur->cb_data.obj->vpi_type->type_code != vpiNamedEvent) {
+		  vpi_get_value(cur->cb_data.obj, &cur->cb_value);
+		  save_value_(cur);
+	    }
+	    entries_.push_back(cur->cb_data);
+      }
+
+      for (size_t idx = 0 ;  idx < value_fix_.size() ;  idx += 1) {
+	    struct t_vpi_value*vp = &value_fix_[idx].first->cb_value;
+	    char*ptr = &value_buf_[value_fix_[idx].second];
+	    switch (vp->format) {
+		case vpiVectorVal:
+		  vp->value.vector = (s_vpi_vecval*)ptr;
+		  break;
+		case vpiStrengthVal:
+		  vp->value.strength = (s_vpi_strengthval*)ptr;
+		  break;
+		case vpiTimeVal:
+		  vp->value.time = (s_vpi_time*)ptr;
+		  break;
+		default:
+		  vp->value.str = ptr;
+		  break;
+	    }
+      }
+
+      for (size_t idx = 0 ;  idx < entries_.size() ;  idx += 1)
+	    entries_[idx].index = entries_.size();
+
+      (entries_[0].cb_rtn)(&entries_[0]);
+}
+
+void value_change_batch_s::run_run()
+{
+      std::vector<struct __vpiCallback*> pending;
+      pending.swap(queue);
+      scheduled = false;
+
+      for (size_t idx = 0 ;  idx < pending.size() ;  idx += 1)
+	    pending[idx]->batch_queued = false;
+
+      assert(vpi_mode_flag == VPI_MODE_NONE);
+      vpi_mode_flag = VPI_MODE_ROSYNC;
+
+	/* Deliver the changes grouped by the function that receives
+	   them, in the order that the functions first appear. */
+      std::vector<struct __vpiCallback*> list;
+      for (size_t idx = 0 ;  idx < pending.size() ;  idx += 1) {
+	    if (pending[idx] == 0)
+		  continue;
+
+	    PLI_INT32 (*rtn)(struct t_cb_data*) = pending[idx]->cb_data.cb_rtn;
+	    list.clear();
+	    for (size_t jdx = idx ;  jdx < pending.size() ;  jdx += 1) {
+		  if (pending[jdx] && pending[jdx]->cb_data.cb_rtn == rtn) {
+			list.push_back(pending[jdx]);
+			pending[jdx] = 0;
+		  }
+	    }
+
+	    if (rtn != 0)
+		  deliver_(list);
+      }
+
+      vpi_mode_flag = VPI_MODE_NONE;
+}
+
 vvp_vpi_callback::vvp_vpi_callback()
 {
       vpi_callbacks_ = 0;
       array_ = 0;
       array_word_ = 0;
+      change_count_ = 0;
 }
 
 vvp_vpi_callback::~vvp_vpi_callback()
@@ -563,6 +770,7 @@ void vvp_vpi_callback::clear_all_callbacks()
  */
 void vvp_vpi_callback::run_vpi_callbacks()
 {
+      change_count_ += 1;
       if (array_) array_word_change(array_, array_word_);
 
       struct __vpiCallback *next = vpi_callbacks_;
@@ -573,7 +781,9 @@ void vvp_vpi_callback::run_vpi_callbacks()
 	    next = cur->next;
 
 	    if (cur->cb_data.cb_rtn != 0) {
-		  if (cur->cb_data.value)
+		    /* Batched callbacks read the value when delivered. */
+		  if (cur->cb_data.value
+		      && cur->cb_data.reason != _cbValueChangeBatch)
 			get_value(cur->cb_data.value);
 
 		  callback_execute(cur);
@@ -173,6 +173,9 @@ struct __vpiCallback {
 	// The callback holder may use this for various purposes.
       long extra_data;
 
+	// Set while a batched value change waits to be delivered.
+      bool batch_queued;
+
 	// Used for listing callbacks.
       struct __vpiCallback*next;
 };
@@ -763,6 +763,28 @@ static vvp_vector4_t from_stringval(const char*str, unsigned wid)
       return val;
 }
 
+extern "C" PLI_INT32 vpip_get_vector_ref(vpiHandle ref, s_vpip_vector_ref*vr)
+{
+      struct __vpiSignal*rfp = vpip_signal_from_handle(ref);
+      if (rfp == 0 || rfp->node->fil == 0)
+	    return 0;
+
+      vvp_signal_value*vsig = dynamic_cast<vvp_signal_value*>(rfp->node->fil);
+      if (vsig == 0)
+	    return 0;
+
+      const vvp_vector4_t*val = vsig->vec4_value_ref();
+      if (val == 0)
+	    return 0;
+
+      vr->size = val->size();
+      vr->word_bits = 8*sizeof(unsigned long);
+      vr->abits = val->abits_words();
+      vr->bbits = val->bbits_words();
+      vr->change_count = rfp->node->fil->change_count();
+      return 1;
+}
+
 static vpiHandle signal_put_value(vpiHandle ref, s_vpi_value*vp, int flags)
 {
       unsigned wid;
@@ -25,6 +25,8 @@
 # include  "event.h"
 # include  "vpi_priv.h"
 # include  "vvp_net_sig.h"
+# include  "statistics.h"
+# include  "profile.h"
 #ifdef CHECK_WITH_VALGRIND
 # include  "vvp_cleanup.h"
 #endif
@@ -133,6 +135,19 @@ struct __vpiScope* vthread_scope(struct vthread_s*thr)
 
 struct vthread_s*running_thread = 0;
 
+/*
+ * The threads woken by event functors are collected into a single
+ * list that one scheduler event runs. This is the list that is
+ * waiting for its event to run, and its last thread. When many event
+ * functors trigger together (e.g. many @(posedge clk) on one clock)
+ * they all add to this list instead of scheduling an event each. The
+ * list only takes threads while its event is the last active event,
+ * so the threads still run in the order they were woken relative to
+ * all the other active events.
+ */
+static vthread_t wakeup_list = 0;
+static vthread_t wakeup_tail = 0;
+
 // this table maps the thread special index bit addresses to
 // vvp_bit4_t bit values.
 static vvp_bit4_t thr_index_to_bit4[4] = { BIT4_0, BIT4_1, BIT4_X, BIT4_Z };
@@ -196,19 +211,61 @@ template <class T> T coerce_to_width(const T&that, unsigned width)
       return res;
 }
 
+/*
+ * The arithmetic and compare opcodes work on the 2-state values of
+ * their operands as arrays of unsigned long. The arrays live in these
+ * scratch buffers, which grow as needed but are never released, so
+ * the opcodes do not allocate memory once the buffers are big
+ * enough. An opcode uses a different slot for each array that it
+ * needs at the same time. None of these opcodes can run another
+ * thread, so the buffers are never in use by two opcodes at once.
+ */
+enum scratch_slot_t { SCRATCH_A = 0, SCRATCH_B, SCRATCH_RES, SCRATCH_DIFF,
+		      SCRATCH_COUNT };
+
+static unsigned long*scratch_arrays[SCRATCH_COUNT];
+static unsigned scratch_words[SCRATCH_COUNT];
+
+static unsigned long* scratch_array(scratch_slot_t slot, unsigned words)
+{
+      if (scratch_words[slot] < words) {
+	    delete[]scratch_arrays[slot];
+	    scratch_arrays[slot] = new unsigned long[words];
+	    scratch_words[slot] = words;
+      }
+      return scratch_arrays[slot];
+}
+
+/*
+ * Some opcodes work on one byte per bit. They get their arrays from
+ * the same scratch slots.
+ */
+static unsigned char* scratch_bytes(scratch_slot_t slot, unsigned bytes)
+{
+      unsigned words = (bytes + sizeof(unsigned long) - 1) / sizeof(unsigned long);
+      return reinterpret_cast<unsigned char*>(scratch_array(slot, words));
+}
+
+/*
+ * Get the 2-state value of the thread bits into the scratch array for
+ * the slot. Return nil if there are any X or Z bits.
+ */
 static unsigned long* vector_to_array(struct vthread_s*thr,
-				      unsigned addr, unsigned wid)
+				      unsigned addr, unsigned wid,
+				      scratch_slot_t slot)
 {
+      if (addr == 2 || addr == 3)
+	    return 0;
+
+      unsigned awid = (wid + CPU_WORD_BITS - 1) / (CPU_WORD_BITS);
+      unsigned long*val = scratch_array(slot, awid);
+
       if (addr == 0) {
-	    unsigned awid = (wid + CPU_WORD_BITS - 1) / (CPU_WORD_BITS);
-	    unsigned long*val = new unsigned long[awid];
 	    for (unsigned idx = 0 ;  idx < awid ;  idx += 1)
 		  val[idx] = 0;
 	    return val;
       }
       if (addr == 1) {
-	    unsigned awid = (wid + CPU_WORD_BITS - 1) / (CPU_WORD_BITS);
-	    unsigned long*val = new unsigned long[awid];
 	    for (unsigned idx = 0 ;  idx < awid ;  idx += 1)
 		  val[idx] = -1UL;
 
@@ -219,10 +276,49 @@ static unsigned long* vector_to_array(struct vthread_s*thr,
 	    return val;
       }
 
-      if (addr < 4)
+      if (! thr->bits4.subarray(val, addr, wid))
 	    return 0;
 
-      return thr->bits4.subarray(addr, wid);
+      return val;
+}
+
+/*
+ * Get/put up to a word of thread bits as abits/bbits words. The
+ * constant bits 0-3 read as a word filled with that value.
+ */
+static inline void thr_get_word4(struct vthread_s*thr, unsigned addr,
+				 unsigned wid, unsigned long&abits,
+				 unsigned long&bbits)
+{
+      if (addr >= 4) {
+	    thr->bits4.get_word(addr, wid, abits, bbits);
+	    return;
+      }
+
+      unsigned long mask = (wid < CPU_WORD_BITS)? (1UL << wid) - 1UL : -1UL;
+      vvp_bit4_t bit = thr_index_to_bit4[addr];
+      abits = (bit & 1)? mask : 0;
+      bbits = (bit & 2)? mask : 0;
+}
+
+static inline void thr_put_word4(struct vthread_s*thr, unsigned addr,
+				 unsigned wid, unsigned long abits,
+				 unsigned long bbits)
+{
+      thr->bits4.set_word(addr, wid, abits, bbits);
+}
+
+/*
+ * Fill the thread bits with X values, a word at a time.
+ */
+static void thr_put_x(struct vthread_s*thr, unsigned addr, unsigned wid)
+{
+      while (wid > 0) {
+	    unsigned trans = wid < CPU_WORD_BITS? wid : CPU_WORD_BITS;
+	    thr_put_word4(thr, addr, trans, -1UL, -1UL);
+	    addr += trans;
+	    wid -= trans;
+      }
 }
 
 /*
@@ -520,13 +616,53 @@ void vthread_delay_delete()
 	    running_thread->delay_delete = 1;
 }
 
+/*
+ * This is the same as the inner loop of vthread_run, but it also
+ * counts the opcodes and times the run for the execution profile.
+ */
+static unsigned long vthread_run_profile_(vthread_t thr)
+{
+	/* Get the scope now, the thread may be reaped before the
+	   run is done. */
+      struct __vpiScope*scope = thr->parent_scope;
+      unsigned long dispatches = 0;
+      clock_t start = clock();
+
+      for (;;) {
+	    vvp_code_t cp = thr->pc;
+	    thr->pc += 1;
+
+	    dispatches += 1;
+	    profile_opcode(cp);
+	    bool rc = (cp->opcode)(thr, cp);
+	    if (rc == false)
+		  break;
+      }
+
+      profile_thread(scope, dispatches, clock() - start);
+      return dispatches;
+}
+
 /*
  * This function runs each thread by fetching an instruction,
  * incrementing the PC, and executing the instruction. The thread may
  * be the head of a list, so each thread is run so far as possible.
+ *
+ * The dispatches are counted locally and added to the global count
+ * when the threads are done, to keep the count out of memory in the
+ * loop.
  */
 void vthread_run(vthread_t thr)
 {
+      unsigned long dispatches = 0;
+
+	/* Once the wakeup list starts to run, it can not take more
+	   threads. Threads woken from now on start a new list. */
+      if (thr == wakeup_list) {
+	    wakeup_list = 0;
+	    wakeup_tail = 0;
+      }
+
       while (thr != 0) {
 	    vthread_t tmp = thr->wait_next;
 	    thr->wait_next = 0;
@@ -536,6 +672,12 @@ void vthread_run(vthread_t thr)
 
             running_thread = thr;
 
+	    if (profile_flag) {
+		  dispatches += vthread_run_profile_(thr);
+		  thr = tmp;
+		  continue;
+	    }
+
 	    for (;;) {
 		  vvp_code_t cp = thr->pc;
 		  thr->pc += 1;
@@ -543,6 +685,7 @@ void vthread_run(vthread_t thr)
 		    /* Run the opcode implementation. If the execution of
 		       the opcode returns false, then the thread is meant to
 		       be paused, so break out of the loop. */
+		  dispatches += 1;
 		  bool rc = (cp->opcode)(thr, cp);
 		  if (rc == false)
 			break;
@@ -551,6 +694,7 @@ void vthread_run(vthread_t thr)
 	    thr = tmp;
       }
       running_thread = 0;
+      count_opcode_dispatches += dispatches;
 }
 
 /*
@@ -571,12 +715,23 @@ bool of_CHUNK_LINK(vthread_t thr, vvp_code_t code)
  */
 void vthread_schedule_list(vthread_t thr)
 {
+      vthread_t tail = thr;
       for (vthread_t cur = thr ;  cur ;  cur = cur->wait_next) {
 	    assert(cur->waiting_for_event);
 	    cur->waiting_for_event = 0;
+	    tail = cur;
+      }
+
+      if (wakeup_list && schedule_vthread_wakeup_is_last()) {
+	    vthread_mark_scheduled(thr);
+	    wakeup_tail->wait_next = thr;
+	    wakeup_tail = tail;
+	    return;
       }
 
-      schedule_vthread(thr, 0);
+      wakeup_list = thr;
+      wakeup_tail = tail;
+      schedule_vthread_wakeup(thr);
 }
 
 vvp_context_t vthread_get_wt_context()
@@ -628,15 +783,47 @@ bool of_ALLOC(vthread_t thr, vvp_code_t cp)
       return true;
 }
 
+/*
+ * The wide logic opcodes work on the thread bits a word at a time,
+ * using the same truth tables as the vvp_vector4_t operators.
+ */
+static inline void and_word4(unsigned long&la, unsigned long&lb,
+			     unsigned long ra, unsigned long rb)
+{
+      unsigned long tmp1 = la | lb;
+      unsigned long tmp2 = ra | rb;
+      la = tmp1 & tmp2;
+      lb = (tmp1 & rb) | (tmp2 & lb);
+}
+
+static inline void or_word4(unsigned long&la, unsigned long&lb,
+			    unsigned long ra, unsigned long rb)
+{
+      unsigned long tmp = la | lb | ra | rb;
+      lb = ((~la | lb) & rb) | ((~ra | rb) & lb);
+      la = tmp;
+}
+
+static inline void inv_word4(unsigned long&la, unsigned long lb)
+{
+      la = ~la | lb;
+}
+
 static bool of_AND_wide(vthread_t thr, vvp_code_t cp)
 {
       unsigned idx1 = cp->bit_idx[0];
       unsigned idx2 = cp->bit_idx[1];
       unsigned wid = cp->number;
 
-      vvp_vector4_t val = vthread_bits_to_vector(thr, idx1, wid);
-      val &= vthread_bits_to_vector(thr, idx2, wid);
-      thr->bits4.set_vec(idx1, val);
+      for (unsigned off = 0 ;  off < wid ;  off += CPU_WORD_BITS) {
+	    unsigned trans = wid - off;
+	    if (trans > CPU_WORD_BITS) trans = CPU_WORD_BITS;
+	    unsigned long la, lb, ra, rb;
+	    thr_get_word4(thr, idx1+off, trans, la, lb);
+	    thr_get_word4(thr, idx2<4? idx2 : idx2+off, trans, ra, rb);
+	    and_word4(la, lb, ra, rb);
+	    thr_put_word4(thr, idx1+off, trans, la, lb);
+      }
 
       return true;
 }
@@ -680,17 +867,16 @@ bool of_ANDI(vthread_t thr, vvp_code_t cp)
 
       assert(idx1 >= 4);
 
-      vvp_vector4_t val = vthread_bits_to_vector(thr, idx1, wid);
-      vvp_vector4_t imv (wid, BIT4_0);
-
-      unsigned trans = wid;
-      if (trans > CPU_WORD_BITS)
-	    trans = CPU_WORD_BITS;
-      imv.setarray(0, trans, &imm);
-
-      val &= imv;
+      for (unsigned off = 0 ;  off < wid ;  off += CPU_WORD_BITS) {
+	    unsigned trans = wid - off;
+	    if (trans > CPU_WORD_BITS) trans = CPU_WORD_BITS;
+	    unsigned long la, lb;
+	    thr_get_word4(thr, idx1+off, trans, la, lb);
+	    and_word4(la, lb, imm, 0);
+	    thr_put_word4(thr, idx1+off, trans, la, lb);
+	    imm = 0;
+      }
 
-      thr->bits4.set_vec(idx1, val);
       return true;
 }
 
@@ -698,8 +884,8 @@ bool of_ADD(vthread_t thr, vvp_code_t cp)
 {
       assert(cp->bit_idx[0] >= 4);
 
-      unsigned long*lva = vector_to_array(thr, cp->bit_idx[0], cp->number);
-      unsigned long*lvb = vector_to_array(thr, cp->bit_idx[1], cp->number);
+      unsigned long*lva = vector_to_array(thr, cp->bit_idx[0], cp->number, SCRATCH_A);
+      unsigned long*lvb = vector_to_array(thr, cp->bit_idx[1], cp->number, SCRATCH_B);
       if (lva == 0 || lvb == 0)
 	    goto x_out;
 
@@ -713,17 +899,10 @@ bool of_ADD(vthread_t thr, vvp_code_t cp)
 
       thr->bits4.setarray(cp->bit_idx[0], cp->number, lva);
 
-      delete[]lva;
-      delete[]lvb;
-
       return true;
 
  x_out:
-      delete[]lva;
-      delete[]lvb;
-
-      vvp_vector4_t tmp(cp->number, BIT4_X);
-      thr->bits4.set_vec(cp->bit_idx[0], tmp);
+      thr_put_x(thr, cp->bit_idx[0], cp->number);
 
       return true;
 }
@@ -753,7 +932,7 @@ bool of_ADDI(vthread_t thr, vvp_code_t cp)
 
       unsigned word_count = (bit_width+CPU_WORD_BITS-1)/CPU_WORD_BITS;
 
-      unsigned long*lva = vector_to_array(thr, bit_addr, bit_width);
+      unsigned long*lva = vector_to_array(thr, bit_addr, bit_width, SCRATCH_A);
       if (lva == 0)
 	    goto x_out;
 
@@ -770,15 +949,10 @@ bool of_ADDI(vthread_t thr, vvp_code_t cp)
 
       thr->bits4.setarray(bit_addr, bit_width, lva);
 
-      delete[]lva;
-
       return true;
 
  x_out:
-      delete[]lva;
-
-      vvp_vector4_t tmp (bit_width, BIT4_X);
-      thr->bits4.set_vec(bit_addr, tmp);
+      thr_put_x(thr, bit_addr, bit_width);
 
       return true;
 }
@@ -1582,7 +1756,7 @@ bool of_CMPIU(vthread_t thr, vvp_code_t cp)
       unsigned long imm  = cp->bit_idx[1];
       unsigned wid  = cp->number;
 
-      unsigned long*array = vector_to_array(thr, addr, wid);
+      unsigned long*array = vector_to_array(thr, addr, wid, SCRATCH_A);
 	// If there are xz bits in the right hand expression, then we
 	// have to do the compare the hard way. That is because even
 	// though we know that eeq must be false (the immediate value
@@ -1602,8 +1776,6 @@ bool of_CMPIU(vthread_t thr, vvp_code_t cp)
 	    lt = (array[idx] < imm) ? BIT4_1 : BIT4_0;
       }
 
-      delete[]array;
-
       thr_put_bit(thr, 4, eq);
       thr_put_bit(thr, 5, lt);
       thr_put_bit(thr, 6, eq);
@@ -1656,14 +1828,11 @@ bool of_CMPU(vthread_t thr, vvp_code_t cp)
       unsigned idx2 = cp->bit_idx[1];
       unsigned wid  = cp->number;
 
-      unsigned long*larray = vector_to_array(thr, idx1, wid);
+      unsigned long*larray = vector_to_array(thr, idx1, wid, SCRATCH_A);
       if (larray == 0) return of_CMPU_the_hard_way(thr, cp);
 
-      unsigned long*rarray = vector_to_array(thr, idx2, wid);
-      if (rarray == 0) {
-	    delete[]larray;
-	    return of_CMPU_the_hard_way(thr, cp);
-      }
+      unsigned long*rarray = vector_to_array(thr, idx2, wid, SCRATCH_B);
+      if (rarray == 0) return of_CMPU_the_hard_way(thr, cp);
 
       unsigned words = (wid+CPU_WORD_BITS-1) / CPU_WORD_BITS;
 
@@ -1678,9 +1847,6 @@ bool of_CMPU(vthread_t thr, vvp_code_t cp)
 		  lt = BIT4_0;
       }
 
-      delete[]larray;
-      delete[]rarray;
-
       thr_put_bit(thr, 4, eq);
       thr_put_bit(thr, 5, lt);
       thr_put_bit(thr, 6, eq);
@@ -2081,8 +2247,8 @@ static unsigned long* divide_bits(unsigned long*ap, unsigned long*bp, unsigned w
 
 	// The result array will eventually accumulate the result. The
 	// diff array is a difference that we use in the intermediate.
-      unsigned long*diff  = new unsigned long[words];
-      unsigned long*result= new unsigned long[words];
+      unsigned long*diff  = scratch_array(SCRATCH_DIFF, words);
+      unsigned long*result= scratch_array(SCRATCH_RES, words);
       for (unsigned idx = 0 ; idx < words ; idx += 1)
 	    result[idx] = 0;
 
@@ -2141,7 +2307,6 @@ static unsigned long* divide_bits(unsigned long*ap, unsigned long*bp, unsigned w
 	// desired result. We should find that:
 	//  input-a = bp * result + ap;
 
-      delete[]diff;
       return result;
 }
 
@@ -2153,41 +2318,32 @@ bool of_DIV(vthread_t thr, vvp_code_t cp)
 
       assert(adra >= 4);
 
-      unsigned long*ap = vector_to_array(thr, adra, wid);
+      unsigned long*ap = vector_to_array(thr, adra, wid, SCRATCH_A);
       if (ap == 0) {
-	    vvp_vector4_t tmp(wid, BIT4_X);
-	    thr->bits4.set_vec(adra, tmp);
+	    thr_put_x(thr, adra, wid);
 	    return true;
       }
 
-      unsigned long*bp = vector_to_array(thr, adrb, wid);
+      unsigned long*bp = vector_to_array(thr, adrb, wid, SCRATCH_B);
       if (bp == 0) {
-	    delete[]ap;
-	    vvp_vector4_t tmp(wid, BIT4_X);
-	    thr->bits4.set_vec(adra, tmp);
+	    thr_put_x(thr, adra, wid);
 	    return true;
       }
 
 	// If the value fits in a single CPU word, then do it the easy way.
       if (wid <= CPU_WORD_BITS) {
 	    if (bp[0] == 0) {
-		  vvp_vector4_t tmp(wid, BIT4_X);
-		  thr->bits4.set_vec(adra, tmp);
+		  thr_put_x(thr, adra, wid);
 	    } else {
 		  ap[0] /= bp[0];
 		  thr->bits4.setarray(adra, wid, ap);
 	    }
-	    delete[]ap;
-	    delete[]bp;
 	    return true;
       }
 
       unsigned long*result = divide_bits(ap, bp, wid);
       if (result == 0) {
-	    delete[]ap;
-	    delete[]bp;
-	    vvp_vector4_t tmp(wid, BIT4_X);
-	    thr->bits4.set_vec(adra, tmp);
+	    thr_put_x(thr, adra, wid);
 	    return true;
       }
 
@@ -2196,9 +2352,6 @@ bool of_DIV(vthread_t thr, vvp_code_t cp)
 	//  input-a = bp * result + ap;
 
       thr->bits4.setarray(adra, wid, result);
-      delete[]ap;
-      delete[]bp;
-      delete[]result;
       return true;
 }
 
@@ -2222,18 +2375,15 @@ bool of_DIV_S(vthread_t thr, vvp_code_t cp)
 	// Get the values, left in right, in binary form. If there is
 	// a problem with either (caused by an X or Z bit) then we
 	// know right away that the entire result is X.
-      unsigned long*ap = vector_to_array(thr, adra, wid);
+      unsigned long*ap = vector_to_array(thr, adra, wid, SCRATCH_A);
       if (ap == 0) {
-	    vvp_vector4_t tmp(wid, BIT4_X);
-	    thr->bits4.set_vec(adra, tmp);
+	    thr_put_x(thr, adra, wid);
 	    return true;
       }
 
-      unsigned long*bp = vector_to_array(thr, adrb, wid);
+      unsigned long*bp = vector_to_array(thr, adrb, wid, SCRATCH_B);
       if (bp == 0) {
-	    delete[]ap;
-	    vvp_vector4_t tmp(wid, BIT4_X);
-	    thr->bits4.set_vec(adra, tmp);
+	    thr_put_x(thr, adra, wid);
 	    return true;
       }
 
@@ -2250,8 +2400,7 @@ bool of_DIV_S(vthread_t thr, vvp_code_t cp)
 	// If the value fits in a single word, then use the native divide.
       if (wid <= CPU_WORD_BITS) {
 	    if (bp[0] == 0) {
-		  vvp_vector4_t tmp(wid, BIT4_X);
-		  thr->bits4.set_vec(adra, tmp);
+		  thr_put_x(thr, adra, wid);
 	    } else {
 		  long tmpa = (long) ap[0];
 		  long tmpb = (long) bp[0];
@@ -2259,8 +2408,6 @@ bool of_DIV_S(vthread_t thr, vvp_code_t cp)
 		  ap[0] = ((unsigned long)res) & ~sign_mask;
 		  thr->bits4.setarray(adra, wid, ap);
 	    }
-	    delete[]ap;
-	    delete[]bp;
 	    return true;
       }
 
@@ -2278,10 +2425,7 @@ bool of_DIV_S(vthread_t thr, vvp_code_t cp)
 
       unsigned long*result = divide_bits(ap, bp, wid);
       if (result == 0) {
-	    delete[]ap;
-	    delete[]bp;
-	    vvp_vector4_t tmp(wid, BIT4_X);
-	    thr->bits4.set_vec(adra, tmp);
+	    thr_put_x(thr, adra, wid);
 	    return true;
       }
 
@@ -2292,9 +2436,6 @@ bool of_DIV_S(vthread_t thr, vvp_code_t cp)
       result[words-1] &= ~sign_mask;
 
       thr->bits4.setarray(adra, wid, result);
-      delete[]ap;
-      delete[]bp;
-      delete[]result;
       return true;
 }
 
@@ -2575,8 +2716,14 @@ static bool of_INV_wide(vthread_t thr, vvp_code_t cp)
       unsigned idx1 = cp->bit_idx[0];
       unsigned wid = cp->bit_idx[1];
 
-      vvp_vector4_t val = vthread_bits_to_vector(thr, idx1, wid);
-      thr->bits4.set_vec(idx1, ~val);
+      for (unsigned off = 0 ;  off < wid ;  off += CPU_WORD_BITS) {
+	    unsigned trans = wid - off;
+	    if (trans > CPU_WORD_BITS) trans = CPU_WORD_BITS;
+	    unsigned long la, lb;
+	    thr_get_word4(thr, idx1+off, trans, la, lb);
+	    inv_word4(la, lb);
+	    thr_put_word4(thr, idx1+off, trans, la, lb);
+      }
 
       return true;
 }
@@ -2970,14 +3117,13 @@ static void load_vp0_common(vthread_t thr, vvp_code_t cp, const vvp_vector4_t&si
 	/* Check the address once, before we scan the vector. */
       thr_check_addr(thr, bit+wid-1);
 
-      unsigned long*val = sig_value.subarray(0, wid);
-      if (val == 0) {
-	    vvp_vector4_t tmp(wid, BIT4_X);
-	    thr->bits4.set_vec(bit, tmp);
+      unsigned words = (wid + CPU_WORD_BITS - 1) / CPU_WORD_BITS;
+      unsigned long*val = scratch_array(SCRATCH_A, words);
+      if (! sig_value.subarray(val, 0, wid)) {
+	    thr_put_x(thr, bit, wid);
 	    return;
       }
 
-      unsigned words = (wid + CPU_WORD_BITS - 1) / CPU_WORD_BITS;
       unsigned long carry = 0;
       unsigned long imm = addend;
       for (unsigned idx = 0 ; idx < words ; idx += 1) {
@@ -2989,7 +3135,6 @@ static void load_vp0_common(vthread_t thr, vvp_code_t cp, const vvp_vector4_t&si
 	/* Copy the vector bits into the bits4 vector. Do the copy
 	   directly to skip the excess calls to thr_check_addr. */
       thr->bits4.setarray(bit, wid, val);
-      delete[]val;
 }
 
 /*
@@ -3268,9 +3413,9 @@ static void do_verylong_mod(vthread_t thr, vvp_code_t cp,
       bool out_is_neg = left_is_neg;
       int len=cp->number;
       unsigned char *a, *z, *t;
-      a = new unsigned char[len+1];
-      z = new unsigned char[len+1];
-      t = new unsigned char[len+1];
+      a = scratch_bytes(SCRATCH_A, len+1);
+      z = scratch_bytes(SCRATCH_B, len+1);
+      t = scratch_bytes(SCRATCH_RES, len+1);
 
       unsigned char carry;
       unsigned char temp;
@@ -3288,12 +3433,8 @@ static void do_verylong_mod(vthread_t thr, vvp_code_t cp,
 	    unsigned lb = thr_get_bit(thr, idx1);
 	    unsigned rb = thr_get_bit(thr, idx2);
 
-	    if ((lb | rb) & 2) {
-		  delete []t;
-		  delete []z;
-		  delete []a;
+	    if ((lb | rb) & 2)
 		  goto x_out;
-	    }
 
 	    if (left_is_neg) {
 		  lb = (1-lb) + lb_carry;
@@ -3332,12 +3473,8 @@ static void do_verylong_mod(vthread_t thr, vvp_code_t cp,
       }
 
       if((mxa>mxz)||(mxa==-1)) {
-	    if(mxa==-1) {
-		  delete []t;
-		  delete []z;
-		  delete []a;
+	    if(mxa==-1)
 		  goto x_out;
-	    }
 
 	    goto tally;
       }
@@ -3375,9 +3512,6 @@ static void do_verylong_mod(vthread_t thr, vvp_code_t cp,
 	    thr_put_bit(thr, cp->bit_idx[0]+idx, ob?BIT4_1:BIT4_0);
       }
 
-      delete []t;
-      delete []z;
-      delete []a;
       return;
 
  x_out:
@@ -3613,6 +3747,31 @@ bool of_MOVI(vthread_t thr, vvp_code_t cp)
       return true;
 }
 
+/*
+ * Multiply the words arrays a and b into res, keeping only the low
+ * words of the product. The res array must not be a or b.
+ */
+static void multiply_array(unsigned long*res, const unsigned long*a,
+			   const unsigned long*b, unsigned words)
+{
+      for (unsigned idx = 0 ; idx < words ; idx += 1)
+	    res[idx] = 0;
+
+      for (unsigned mul_a = 0 ; mul_a < words ; mul_a += 1) {
+	    for (unsigned mul_b = 0 ; mul_b < (words-mul_a) ; mul_b += 1) {
+		  unsigned long sum;
+		  unsigned long tmp = multiply_with_carry(a[mul_a], b[mul_b], sum);
+		  unsigned base = mul_a + mul_b;
+		  unsigned long carry = 0;
+		  res[base] = add_with_carry(res[base], tmp, carry);
+		  for (unsigned add_idx = base+1; add_idx < words; add_idx += 1) {
+			res[add_idx] = add_with_carry(res[add_idx], sum, carry);
+			sum = 0;
+		  }
+	    }
+      }
+}
+
 bool of_MUL(vthread_t thr, vvp_code_t cp)
 {
       unsigned adra = cp->bit_idx[0];
@@ -3621,18 +3780,15 @@ bool of_MUL(vthread_t thr, vvp_code_t cp)
 
       assert(adra >= 4);
 
-      unsigned long*ap = vector_to_array(thr, adra, wid);
+      unsigned long*ap = vector_to_array(thr, adra, wid, SCRATCH_A);
       if (ap == 0) {
-	    vvp_vector4_t tmp(wid, BIT4_X);
-	    thr->bits4.set_vec(adra, tmp);
+	    thr_put_x(thr, adra, wid);
 	    return true;
       }
 
-      unsigned long*bp = vector_to_array(thr, adrb, wid);
+      unsigned long*bp = vector_to_array(thr, adrb, wid, SCRATCH_B);
       if (bp == 0) {
-	    delete[]ap;
-	    vvp_vector4_t tmp(wid, BIT4_X);
-	    thr->bits4.set_vec(adra, tmp);
+	    thr_put_x(thr, adra, wid);
 	    return true;
       }
 
@@ -3640,34 +3796,14 @@ bool of_MUL(vthread_t thr, vvp_code_t cp)
       if (wid <= CPU_WORD_BITS) {
 	    ap[0] *= bp[0];
 	    thr->bits4.setarray(adra, wid, ap);
-	    delete[]ap;
-	    delete[]bp;
 	    return true;
       }
 
       unsigned words = (wid+CPU_WORD_BITS-1) / CPU_WORD_BITS;
-      unsigned long*res = new unsigned long[words];
-      for (unsigned idx = 0 ; idx < words ; idx += 1)
-	    res[idx] = 0;
-
-      for (unsigned mul_a = 0 ; mul_a < words ; mul_a += 1) {
-	    for (unsigned mul_b = 0 ; mul_b < (words-mul_a) ; mul_b += 1) {
-		  unsigned long sum;
-		  unsigned long tmp = multiply_with_carry(ap[mul_a], bp[mul_b], sum);
-		  unsigned base = mul_a + mul_b;
-		  unsigned long carry = 0;
-		  res[base] = add_with_carry(res[base], tmp, carry);
-		  for (unsigned add_idx = base+1; add_idx < words; add_idx += 1) {
-			res[add_idx] = add_with_carry(res[add_idx], sum, carry);
-			sum = 0;
-		  }
-	    }
-      }
+      unsigned long*res = scratch_array(SCRATCH_RES, words);
+      multiply_array(res, ap, bp, words);
 
       thr->bits4.setarray(adra, wid, res);
-      delete[]ap;
-      delete[]bp;
-      delete[]res;
       return true;
 }
 
@@ -3688,11 +3824,10 @@ bool of_MULI(vthread_t thr, vvp_code_t cp)
 
       assert(adr >= 4);
 
-      unsigned long*val = vector_to_array(thr, adr, wid);
+      unsigned long*val = vector_to_array(thr, adr, wid, SCRATCH_A);
 	// If there are X bits in the value, then return X.
       if (val == 0) {
-	    vvp_vector4_t tmp(cp->number, BIT4_X);
-	    thr->bits4.set_vec(cp->bit_idx[0], tmp);
+	    thr_put_x(thr, adr, wid);
 	    return true;
       }
 
@@ -3700,18 +3835,15 @@ bool of_MULI(vthread_t thr, vvp_code_t cp)
       if (wid <= CPU_WORD_BITS) {
 	    val[0] *= imm;
 	    thr->bits4.setarray(adr, wid, val);
-	    delete[]val;
 	    return true;
       }
 
       unsigned words = (wid+CPU_WORD_BITS-1) / CPU_WORD_BITS;
-      unsigned long*res = new unsigned long[words];
+      unsigned long*res = scratch_array(SCRATCH_RES, words);
 
       multiply_array_imm(res, val, words, imm);
 
       thr->bits4.setarray(adr, wid, res);
-      delete[]val;
-      delete[]res;
       return true;
 }
 
@@ -3721,9 +3853,16 @@ static bool of_NAND_wide(vthread_t thr, vvp_code_t cp)
       unsigned idx2 = cp->bit_idx[1];
       unsigned wid = cp->number;
 
-      vvp_vector4_t val = vthread_bits_to_vector(thr, idx1, wid);
-      val &= vthread_bits_to_vector(thr, idx2, wid);
-      thr->bits4.set_vec(idx1, ~val);
+      for (unsigned off = 0 ;  off < wid ;  off += CPU_WORD_BITS) {
+	    unsigned trans = wid - off;
+	    if (trans > CPU_WORD_BITS) trans = CPU_WORD_BITS;
+	    unsigned long la, lb, ra, rb;
+	    thr_get_word4(thr, idx1+off, trans, la, lb);
+	    thr_get_word4(thr, idx2<4? idx2 : idx2+off, trans, ra, rb);
+	    and_word4(la, lb, ra, rb);
+	    inv_word4(la, lb);
+	    thr_put_word4(thr, idx1+off, trans, la, lb);
+      }
 
       return true;
 }
@@ -3912,9 +4051,15 @@ static bool of_OR_wide(vthread_t thr, vvp_code_t cp)
       unsigned idx2 = cp->bit_idx[1];
       unsigned wid = cp->number;
 
-      vvp_vector4_t val = vthread_bits_to_vector(thr, idx1, wid);
-      val |= vthread_bits_to_vector(thr, idx2, wid);
-      thr->bits4.set_vec(idx1, val);
+      for (unsigned off = 0 ;  off < wid ;  off += CPU_WORD_BITS) {
+	    unsigned trans = wid - off;
+	    if (trans > CPU_WORD_BITS) trans = CPU_WORD_BITS;
+	    unsigned long la, lb, ra, rb;
+	    thr_get_word4(thr, idx1+off, trans, la, lb);
+	    thr_get_word4(thr, idx2<4? idx2 : idx2+off, trans, ra, rb);
+	    or_word4(la, lb, ra, rb);
+	    thr_put_word4(thr, idx1+off, trans, la, lb);
+      }
 
       return true;
 }
@@ -3957,9 +4102,16 @@ static bool of_NOR_wide(vthread_t thr, vvp_code_t cp)
       unsigned idx2 = cp->bit_idx[1];
       unsigned wid = cp->number;
 
-      vvp_vector4_t val = vthread_bits_to_vector(thr, idx1, wid);
-      val |= vthread_bits_to_vector(thr, idx2, wid);
-      thr->bits4.set_vec(idx1, ~val);
+      for (unsigned off = 0 ;  off < wid ;  off += CPU_WORD_BITS) {
+	    unsigned trans = wid - off;
+	    if (trans > CPU_WORD_BITS) trans = CPU_WORD_BITS;
+	    unsigned long la, lb, ra, rb;
+	    thr_get_word4(thr, idx1+off, trans, la, lb);
+	    thr_get_word4(thr, idx2<4? idx2 : idx2+off, trans, ra, rb);
+	    or_word4(la, lb, ra, rb);
+	    inv_word4(la, lb);
+	    thr_put_word4(thr, idx1+off, trans, la, lb);
+      }
 
       return true;
 }
@@ -3994,44 +4146,70 @@ bool of_NOR(vthread_t thr, vvp_code_t cp)
       return cp->opcode(thr, cp);
 }
 
+/*
+ * Only the low wid bits of the unsigned power are kept, so %pow works
+ * modulo 2**(words*CPU_WORD_BITS) with square and multiply in the
+ * scratch arrays. The full power is never made.
+ */
 bool of_POW(vthread_t thr, vvp_code_t cp)
 {
       assert(cp->bit_idx[0] >= 4);
 
-      unsigned idx = cp->bit_idx[0];
-      unsigned idy = cp->bit_idx[1];
+      unsigned adra = cp->bit_idx[0];
+      unsigned adrb = cp->bit_idx[1];
       unsigned wid = cp->number;
-      vvp_vector2_t xv2 = vvp_vector2_t(vthread_bits_to_vector(thr, idx, wid));
-      vvp_vector2_t yv2 = vvp_vector2_t(vthread_bits_to_vector(thr, idy, wid));
 
         /* If we have an X or Z in the arguments return X. */
-      if (xv2.is_NaN() || yv2.is_NaN()) {
-	    for (unsigned jdx = 0 ;  jdx < wid ;  jdx += 1)
-		  thr_put_bit(thr, cp->bit_idx[0]+jdx, BIT4_X);
+      unsigned long*xp = vector_to_array(thr, adra, wid, SCRATCH_A);
+      if (xp == 0) {
+	    thr_put_x(thr, adra, wid);
 	    return true;
       }
 
-        /* To make the result more manageable trim off the extra bits. */
-      xv2.trim();
-      yv2.trim();
+      unsigned long*yp = vector_to_array(thr, adrb, wid, SCRATCH_B);
+      if (yp == 0) {
+	    thr_put_x(thr, adra, wid);
+	    return true;
+      }
 
-      vvp_vector2_t result = pow(xv2, yv2);
+      unsigned words = (wid+CPU_WORD_BITS-1) / CPU_WORD_BITS;
+      unsigned long*res = scratch_array(SCRATCH_RES, words);
+      unsigned long*tmp = scratch_array(SCRATCH_DIFF, words);
 
-        /* If the result is too small zero pad it. */
-      if (result.size() < wid) {
-	    for (unsigned jdx = wid-1;  jdx >= result.size();  jdx -= 1)
-		  thr_put_bit(thr, cp->bit_idx[0]+jdx, BIT4_0);
-	    wid = result.size();
-      }
+      res[0] = 1;
+      for (unsigned idx = 1 ; idx < words ; idx += 1)
+	    res[idx] = 0;
 
-        /* Copy only what we need of the result. */
-      for (unsigned jdx = 0;  jdx < wid;  jdx += 1)
-	    thr_put_bit(thr, cp->bit_idx[0]+jdx,
-	                result.value(jdx) ? BIT4_1 : BIT4_0);
+	/* Find the most significant 1 bit of the exponent. */
+      unsigned ybits = wid;
+      while (ybits > 0 && ((yp[(ybits-1)/CPU_WORD_BITS]
+			    >> ((ybits-1)%CPU_WORD_BITS)) & 1) == 0)
+	    ybits -= 1;
+
+      for (unsigned idx = 0 ;  idx < ybits ;  idx += 1) {
+	    if ((yp[idx/CPU_WORD_BITS] >> (idx%CPU_WORD_BITS)) & 1) {
+		  multiply_array(tmp, res, xp, words);
+		  for (unsigned jdx = 0 ; jdx < words ; jdx += 1)
+			res[jdx] = tmp[jdx];
+	    }
 
+	    if (idx+1 < ybits) {
+		  multiply_array(tmp, xp, xp, words);
+		  for (unsigned jdx = 0 ; jdx < words ; jdx += 1)
+			xp[jdx] = tmp[jdx];
+	    }
+      }
+
+      thr->bits4.setarray(adra, wid, res);
       return true;
 }
 
+/*
+ * %pow/s is done with the double pow() function. Operands of up to a
+ * word fit in the vectors without allocating. Wider operands still
+ * go through heap vectors, so the rounding stays the same as that of
+ * the vector4 to double conversion.
+ */
 bool of_POW_S(vthread_t thr, vvp_code_t cp)
 {
       assert(cp->bit_idx[0] >= 4);
@@ -4412,8 +4590,8 @@ bool of_SUB(vthread_t thr, vvp_code_t cp)
 {
       assert(cp->bit_idx[0] >= 4);
 
-      unsigned long*lva = vector_to_array(thr, cp->bit_idx[0], cp->number);
-      unsigned long*lvb = vector_to_array(thr, cp->bit_idx[1], cp->number);
+      unsigned long*lva = vector_to_array(thr, cp->bit_idx[0], cp->number, SCRATCH_A);
+      unsigned long*lvb = vector_to_array(thr, cp->bit_idx[1], cp->number, SCRATCH_B);
       if (lva == 0 || lvb == 0)
 	    goto x_out;
 
@@ -4428,17 +4606,11 @@ bool of_SUB(vthread_t thr, vvp_code_t cp)
 	   in the thr->bitr4 vector, so just do the set bit. */
 
       thr->bits4.setarray(cp->bit_idx[0], cp->number, lva);
-      delete[]lva;
-      delete[]lvb;
 
       return true;
 
  x_out:
-      delete[]lva;
-      delete[]lvb;
-
-      vvp_vector4_t tmp(cp->number, BIT4_X);
-      thr->bits4.set_vec(cp->bit_idx[0], tmp);
+      thr_put_x(thr, cp->bit_idx[0], cp->number);
 
       return true;
 }
@@ -4457,7 +4629,7 @@ bool of_SUBI(vthread_t thr, vvp_code_t cp)
 
       unsigned word_count = (cp->number+CPU_WORD_BITS-1)/CPU_WORD_BITS;
       unsigned long imm = cp->bit_idx[1];
-      unsigned long*lva = vector_to_array(thr, cp->bit_idx[0], cp->number);
+      unsigned long*lva = vector_to_array(thr, cp->bit_idx[0], cp->number, SCRATCH_A);
       if (lva == 0)
 	    goto x_out;
 
@@ -4474,15 +4646,10 @@ bool of_SUBI(vthread_t thr, vvp_code_t cp)
 
       thr->bits4.setarray(cp->bit_idx[0], cp->number, lva);
 
-      delete[]lva;
-
       return true;
 
  x_out:
-      delete[]lva;
-
-      vvp_vector4_t tmp(cp->number, BIT4_X);
-      thr->bits4.set_vec(cp->bit_idx[0], tmp);
+      thr_put_x(thr, cp->bit_idx[0], cp->number);
 
       return true;
 }
@@ -4660,3 +4827,100 @@ bool of_EXEC_UFUNC(vthread_t thr, vvp_code_t cp)
 
       return true;
 }
+
+/*
+ * Superinstructions
+ *
+ * The code generator emits a few instruction sequences very often,
+ * i.e. %load/v followed by %cmpi/u and %jmp/0xz for an if statement,
+ * or %cmpi/u followed by %jmp/1 for each case item. After the code is
+ * linked, codespace_fuse() replaces the opcode of the first
+ * instruction of each such sequence with a superinstruction that runs
+ * the whole sequence with a single dispatch. The superinstruction
+ * gets the operands of each step from the original instructions, and
+ * the opcodes of the following instructions are left alone so that
+ * jumps into the middle of a sequence still work.
+ *
+ * Only the last instruction of a sequence may change the pc, so each
+ * step is called with the pc pointing just past its instruction, as
+ * if it were dispatched by vthread_run. The steps after the first are
+ * counted, so that the statistics can report the instructions run as
+ * well as the dispatches.
+ */
+template <vvp_code_fun OP1, vvp_code_fun OP2>
+static bool of_FUSED2(vthread_t thr, vvp_code_t cp)
+{
+      if (! OP1(thr, cp))
+	    return false;
+      count_opcode_fused_steps += 1;
+      thr->pc = cp + 2;
+      return OP2(thr, cp + 1);
+}
+
+template <vvp_code_fun OP1, vvp_code_fun OP2, vvp_code_fun OP3>
+static bool of_FUSED3(vthread_t thr, vvp_code_t cp)
+{
+      if (! OP1(thr, cp))
+	    return false;
+      count_opcode_fused_steps += 1;
+      thr->pc = cp + 2;
+      if (! OP2(thr, cp + 1))
+	    return false;
+      count_opcode_fused_steps += 1;
+      thr->pc = cp + 3;
+      return OP3(thr, cp + 2);
+}
+
+struct code_fusion_s {
+      unsigned count;
+      vvp_code_fun seq[3];
+      vvp_code_fun fused;
+};
+
+/*
+ * The longer sequences are listed first so that they are preferred
+ * over their prefixes.
+ */
+static const struct code_fusion_s code_fusion_table[] = {
+      { 3, {of_LOAD_VEC, of_CMPIU, of_JMP0XZ},
+	&of_FUSED3<of_LOAD_VEC, of_CMPIU, of_JMP0XZ> },
+      { 3, {of_LOAD_VEC, of_CMPIU, of_JMP1},
+	&of_FUSED3<of_LOAD_VEC, of_CMPIU, of_JMP1> },
+      { 3, {of_LOAD_VEC, of_ADDI, of_SET_VEC},
+	&of_FUSED3<of_LOAD_VEC, of_ADDI, of_SET_VEC> },
+      { 2, {of_LOAD_VEC, of_JMP0XZ, 0},
+	&of_FUSED2<of_LOAD_VEC, of_JMP0XZ> },
+      { 2, {of_LOAD_VEC, of_CMPIU, 0},
+	&of_FUSED2<of_LOAD_VEC, of_CMPIU> },
+      { 2, {of_CMPIU, of_JMP1, 0},
+	&of_FUSED2<of_CMPIU, of_JMP1> },
+      { 2, {of_CMPIU, of_JMP0XZ, 0},
+	&of_FUSED2<of_CMPIU, of_JMP0XZ> },
+      { 2, {of_CMPU, of_JMP1, 0},
+	&of_FUSED2<of_CMPU, of_JMP1> },
+      { 2, {of_CMPU, of_JMP0XZ, 0},
+	&of_FUSED2<of_CMPU, of_JMP0XZ> },
+      { 2, {of_CMPS, of_JMP0XZ, 0},
+	&of_FUSED2<of_CMPS, of_JMP0XZ> },
+      { 2, {of_SET_VEC, of_JMP, 0},
+	&of_FUSED2<of_SET_VEC, of_JMP> },
+      { 0, {0, 0, 0}, 0 }
+};
+
+vvp_code_fun vthread_fused_opcode(vvp_code_t cp, unsigned avail)
+{
+      for (const struct code_fusion_s*cur = code_fusion_table
+		 ; cur->count ; cur += 1) {
+	    if (cur->count > avail)
+		  continue;
+
+	    unsigned idx = 0;
+	    while (idx < cur->count && cp[idx].opcode == cur->seq[idx])
+		  idx += 1;
+
+	    if (idx == cur->count)
+		  return cur->fused;
+      }
+
+      return 0;
+}
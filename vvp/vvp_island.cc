@@ -30,6 +30,7 @@
 # include  <cassert>
 # include  <cstdlib>
 # include  <cstring>
+# include  <climits>
 # include "ivl_alloc.h"
 
 static bool at_EOS = false;
@@ -68,8 +69,13 @@ vvp_island::~vvp_island()
       }
 }
 
-void vvp_island::flag_island()
+void vvp_island::flag_island(vvp_island_port*port)
 {
+      if (! port->flagged) {
+	    port->flagged = true;
+	    flagged_ports_.push_back(port);
+      }
+
       if (flagged_ == true)
 	    return;
 
@@ -159,7 +165,7 @@ void vvp_island::compile_cleanup()
 }
 
 vvp_island_port::vvp_island_port(vvp_island*ip)
-: island_(ip)
+: flagged(false), index(UINT_MAX), island_(ip)
 {
 }
 
@@ -175,7 +181,7 @@ void vvp_island_port::recv_vec4(vvp_net_ptr_t, const vvp_vector4_t&bit,
 	    return;
 
       invalue = tmp;
-      island_->flag_island();
+      island_->flag_island(this);
 }
 
 void vvp_island_port::recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
@@ -193,7 +199,7 @@ void vvp_island_port::recv_vec8(vvp_net_ptr_t, const vvp_vector8_t&bit)
 	    return;
 
       invalue = bit;
-      island_->flag_island();
+      island_->flag_island(this);
 }
 
 void vvp_island_port::recv_vec8_pv(vvp_net_ptr_t, const vvp_vector8_t&bit,
@@ -211,12 +217,12 @@ void vvp_island_port::recv_vec8_pv(vvp_net_ptr_t, const vvp_vector8_t&bit,
 	    }
       }
 
-      island_->flag_island();
+      island_->flag_island(this);
 }
 
 void vvp_island_port::force_flag(void)
 {
-      island_->flag_island();
+      island_->flag_island(this);
 }
 
 vvp_island_branch::~vvp_island_branch()
@@ -25,6 +25,7 @@
 # include  "symbols.h"
 # include  "schedule.h"
 # include  <list>
+# include  <vector>
 # include  <cassert>
 
 /*
@@ -56,6 +57,7 @@
 
 class vvp_island_branch;
 class vvp_island_node;
+class vvp_island_port;
 
 class vvp_island  : private vvp_gen_event_s {
 
@@ -67,7 +69,7 @@ class vvp_island  : private vvp_gen_event_s {
 	// the input. The island will use this to create an active
 	// event. The run_run() method will then be called by the
 	// scheduler to process whatever happened.
-      void flag_island();
+      void flag_island(vvp_island_port*port);
 
 	// This is the method that is called, eventually, to process
 	// whatever happened. The derived island class implements this
@@ -80,6 +82,12 @@ class vvp_island  : private vvp_gen_event_s {
 	// scanning the mesh.
       vvp_island_branch*branches_;
 
+	// These are the ports that were flagged since the island last
+	// ran. The derived island class uses this list to limit its
+	// work to the parts of the island that the ports touch, and
+	// clears the list and the flagged marks of the ports.
+      std::vector<vvp_island_port*> flagged_ports_;
+
     public: /* These methods are used during linking. */
 
 	// Add a port to the island. The key is added to the island
@@ -140,6 +148,11 @@ class vvp_island_port  : public vvp_net_fun_t {
       vvp_vector8_t invalue;
       vvp_vector8_t outvalue;
 
+	// The island uses these to keep track of the ports that
+	// changed, and to number its ports.
+      bool flagged;
+      unsigned index;
+
     private:
       vvp_island*island_;
 
@@ -489,6 +489,7 @@ const vvp_vector4_t vvp_vector4_t::nil;
 
 void vvp_vector4_t::copy_bits(const vvp_vector4_t&that)
 {
+      unshare_();
 
       if (size_ == that.size_) {
 	    if (size_ > BITS_PER_WORD) {
@@ -538,13 +539,12 @@ void vvp_vector4_t::copy_bits(const vvp_vector4_t&that)
 	   source is short, then mask/copy from its value. */
       if (that.size_ <= BITS_PER_WORD) {
 	    unsigned long mask;
-	    if (that.size_ < BITS_PER_WORD) {
+	    if (that.size_ < BITS_PER_WORD)
 		  mask = (1UL << that.size_) - 1UL;
-		  abits_ptr_[0] &= ~mask;
-		  bbits_ptr_[0] &= ~mask;
-	    } else {
+	    else
 		  mask = -1UL;
-	    }
+	    abits_ptr_[0] &= ~mask;
+	    bbits_ptr_[0] &= ~mask;
 	    abits_ptr_[0] |= that.abits_val_&mask;
 	    bbits_ptr_[0] |= that.bbits_val_&mask;
 	    return;
@@ -573,14 +573,12 @@ void vvp_vector4_t::copy_from_(const vvp_vector4_t&that)
 {
       size_ = that.size_;
       if (size_ > BITS_PER_WORD) {
-	    unsigned words = (size_+BITS_PER_WORD-1) / BITS_PER_WORD;
-	    abits_ptr_ = new unsigned long[2*words];
-	    bbits_ptr_ = abits_ptr_ + words;
-
-	    for (unsigned idx = 0 ;  idx < words ;  idx += 1)
-		  abits_ptr_[idx] = that.abits_ptr_[idx];
-	    for (unsigned idx = 0 ;  idx < words ;  idx += 1)
-		  bbits_ptr_[idx] = that.bbits_ptr_[idx];
+	      // Share the bit array with that vector. It will be
+	      // copied if and when either vector is changed.
+	    abits_ptr_ = that.abits_ptr_;
+	    bbits_ptr_ = that.bbits_ptr_;
+	    abits_ptr_[-1] += 1;
+	    count_vector4_shared += 1;
 
       } else {
 	    abits_val_ = that.abits_val_;
@@ -598,7 +596,7 @@ void vvp_vector4_t::copy_inverted_from_(const vvp_vector4_t&that)
       size_ = that.size_;
       if (size_ > BITS_PER_WORD) {
 	    unsigned words = (size_+BITS_PER_WORD-1) / BITS_PER_WORD;
-	    abits_ptr_ = new unsigned long[2*words];
+	    abits_ptr_ = allocate_bits_(words);
 	    bbits_ptr_ = abits_ptr_ + words;
 
 	    unsigned remaining = size_;
@@ -623,12 +621,46 @@ void vvp_vector4_t::copy_inverted_from_(const vvp_vector4_t&that)
       }
 }
 
+/*
+ * Allocate the heap array for cnt words of abits and bbits. The array
+ * has an extra word in front for the reference count, and the
+ * returned pointer points past it to the abits.
+ */
+unsigned long* vvp_vector4_t::allocate_bits_(unsigned cnt)
+{
+      unsigned long*bits = new unsigned long[2*cnt+1];
+      bits[0] = 1;
+      count_vector4_allocs += 1;
+      return bits + 1;
+}
+
+/*
+ * Replace the shared bit array with a private copy, so that this
+ * vector can be changed without affecting the other vectors that
+ * share the array.
+ */
+void vvp_vector4_t::unshare_words_()
+{
+      unsigned words = (size_+BITS_PER_WORD-1) / BITS_PER_WORD;
+      unsigned long*bits = allocate_bits_(words);
+
+      for (unsigned idx = 0 ;  idx < words ;  idx += 1)
+	    bits[idx] = abits_ptr_[idx];
+      for (unsigned idx = 0 ;  idx < words ;  idx += 1)
+	    bits[words+idx] = bbits_ptr_[idx];
+
+      abits_ptr_[-1] -= 1;
+      abits_ptr_ = bits;
+      bbits_ptr_ = bits + words;
+      count_vector4_unshared += 1;
+}
+
 /* Make sure to set size_ before calling this routine. */
 void vvp_vector4_t::allocate_words_(unsigned long inita, unsigned long initb)
 {
       if (size_ > BITS_PER_WORD) {
 	    unsigned cnt = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
-	    abits_ptr_ = new unsigned long[2*cnt];
+	    abits_ptr_ = allocate_bits_(cnt);
 	    bbits_ptr_ = abits_ptr_ + cnt;
 	    for (unsigned idx = 0 ;  idx < cnt ;  idx += 1)
 		  abits_ptr_[idx] = inita;
@@ -831,7 +863,7 @@ void vvp_vector4_t::resize(unsigned newsize)
 		  return;
 	    }
 
-	    unsigned long*newbits = new unsigned long[2*newcnt];
+	    unsigned long*newbits = allocate_bits_(newcnt);
 
 	    if (cnt > 1) {
 		  unsigned trans = cnt;
@@ -843,7 +875,7 @@ void vvp_vector4_t::resize(unsigned newsize)
 		  for (unsigned idx = 0 ;  idx < trans ;  idx += 1)
 			newbits[newcnt+idx] = bbits_ptr_[idx];
 
-		  delete[]abits_ptr_;
+		  release_bits_();
 
 	    } else {
 		  newbits[0] = abits_val_;
@@ -863,7 +895,7 @@ void vvp_vector4_t::resize(unsigned newsize)
 	    if (cnt > 1) {
 		  unsigned long newvala = abits_ptr_[0];
 		  unsigned long newvalb = bbits_ptr_[0];
-		  delete[]abits_ptr_;
+		  release_bits_();
 		  abits_val_ = newvala;
 		  bbits_val_ = newvalb;
 	    }
@@ -879,6 +911,19 @@ unsigned long* vvp_vector4_t::subarray(unsigned adr, unsigned wid) const
       unsigned awid = (wid + BIT2_PER_WORD - 1) / (BIT2_PER_WORD);
       unsigned long*val = new unsigned long[awid];
 
+      if (! subarray(val, adr, wid)) {
+	    delete[]val;
+	    return 0;
+      }
+
+      return val;
+}
+
+bool vvp_vector4_t::subarray(unsigned long*val, unsigned adr, unsigned wid) const
+{
+      const unsigned BIT2_PER_WORD = 8*sizeof(unsigned long);
+      unsigned awid = (wid + BIT2_PER_WORD - 1) / (BIT2_PER_WORD);
+
       for (unsigned idx = 0 ;  idx < awid ;  idx += 1)
 	    val[idx] = 0;
 
@@ -894,7 +939,7 @@ unsigned long* vvp_vector4_t::subarray(unsigned adr, unsigned wid) const
 		  atmp &= (1UL << wid) - 1;
 		  btmp &= (1UL << wid) - 1;
 	    }
-	    if (btmp) goto x_out;
+	    if (btmp) return false;
 
 	    val[0] = atmp;
 
@@ -921,7 +966,7 @@ unsigned long* vvp_vector4_t::subarray(unsigned adr, unsigned wid) const
 			atmp &= (1UL << trans) - 1;
 			btmp &= (1UL << trans) - 1;
 		  }
-		  if (btmp) goto x_out;
+		  if (btmp) return false;
 
 		  val[val_ptr] |= atmp << val_off;
 		  adr += trans;
@@ -934,16 +979,74 @@ unsigned long* vvp_vector4_t::subarray(unsigned adr, unsigned wid) const
 	    }
       }
 
-      return val;
+      return true;
+}
 
- x_out:
-      delete[]val;
-      return 0;
+void vvp_vector4_t::get_word(unsigned adr, unsigned wid,
+			     unsigned long&abits, unsigned long&bbits) const
+{
+      assert(wid > 0 && wid <= BITS_PER_WORD);
+      assert(adr+wid <= size_);
+
+      unsigned long mask = (wid < BITS_PER_WORD)? (1UL << wid) - 1UL : -1UL;
+
+      if (size_ <= BITS_PER_WORD) {
+	    abits = (abits_val_ >> adr) & mask;
+	    bbits = (bbits_val_ >> adr) & mask;
+	    return;
+      }
+
+      unsigned ptr = adr / BITS_PER_WORD;
+      unsigned off = adr % BITS_PER_WORD;
+
+      abits = abits_ptr_[ptr] >> off;
+      bbits = bbits_ptr_[ptr] >> off;
+	/* If the part spills into the next word, pick up the rest of
+	   the bits from there. */
+      if (off > 0 && (off+wid) > BITS_PER_WORD) {
+	    abits |= abits_ptr_[ptr+1] << (BITS_PER_WORD-off);
+	    bbits |= bbits_ptr_[ptr+1] << (BITS_PER_WORD-off);
+      }
+
+      abits &= mask;
+      bbits &= mask;
+}
+
+void vvp_vector4_t::set_word(unsigned adr, unsigned wid,
+			     unsigned long abits, unsigned long bbits)
+{
+      assert(wid > 0 && wid <= BITS_PER_WORD);
+      assert(adr+wid <= size_);
+      unshare_();
+
+      unsigned long mask = (wid < BITS_PER_WORD)? (1UL << wid) - 1UL : -1UL;
+      abits &= mask;
+      bbits &= mask;
+
+      if (size_ <= BITS_PER_WORD) {
+	    abits_val_ = (abits_val_ & ~(mask << adr)) | (abits << adr);
+	    bbits_val_ = (bbits_val_ & ~(mask << adr)) | (bbits << adr);
+	    return;
+      }
+
+      unsigned ptr = adr / BITS_PER_WORD;
+      unsigned off = adr % BITS_PER_WORD;
+
+      abits_ptr_[ptr] = (abits_ptr_[ptr] & ~(mask << off)) | (abits << off);
+      bbits_ptr_[ptr] = (bbits_ptr_[ptr] & ~(mask << off)) | (bbits << off);
+	/* If the part spills into the next word, write the rest of
+	   the bits there. */
+      if (off > 0 && (off+wid) > BITS_PER_WORD) {
+	    unsigned sh = BITS_PER_WORD - off;
+	    abits_ptr_[ptr+1] = (abits_ptr_[ptr+1] & ~(mask >> sh)) | (abits >> sh);
+	    bbits_ptr_[ptr+1] = (bbits_ptr_[ptr+1] & ~(mask >> sh)) | (bbits >> sh);
+      }
 }
 
 void vvp_vector4_t::setarray(unsigned adr, unsigned wid, const unsigned long*val)
 {
       assert(adr+wid <= size_);
+      unshare_();
 
       const unsigned BIT2_PER_WORD = 8*sizeof(unsigned long);
 
@@ -1015,6 +1118,7 @@ void vvp_vector4_t::setarray(unsigned adr, unsigned wid, const unsigned long*val
 void vvp_vector4_t::set_vec(unsigned adr, const vvp_vector4_t&that)
 {
       assert(adr+that.size_  <= size_);
+      unshare_();
 
       if (size_ <= BITS_PER_WORD) {
 
@@ -1176,6 +1280,7 @@ void vvp_vector4_t::mov(unsigned dst, unsigned src, unsigned cnt)
 {
       assert(dst+cnt <= size_);
       assert(src+cnt <= size_);
+      unshare_();
 
       if (size_ <= BITS_PER_WORD) {
 	    unsigned long vmask = (1UL << cnt) - 1;
@@ -1347,6 +1452,7 @@ void vvp_vector4_t::change_z2x()
 	// or-ing the bbit into the abit, BIT4_X and BIT4_Z both
 	// become BIT4_X.
 
+      unshare_();
       if (size_ <= BITS_PER_WORD) {
 	    abits_val_ |= bbits_val_;
       } else {
@@ -1358,6 +1464,7 @@ void vvp_vector4_t::change_z2x()
 
 void vvp_vector4_t::set_to_x()
 {
+      unshare_();
       if (size_ <= BITS_PER_WORD) {
 	    abits_val_ = vvp_vector4_t::WORD_X_ABITS;
             bbits_val_ = vvp_vector4_t::WORD_X_BBITS;
@@ -1402,6 +1509,7 @@ char* vvp_vector4_t::as_string(char*buf, size_t buf_len)
 
 void vvp_vector4_t::invert()
 {
+      unshare_();
       if (size_ <= BITS_PER_WORD) {
 	    unsigned long mask = (size_<BITS_PER_WORD)? (1UL<<size_)-1UL : -1UL;
 	    abits_val_ = mask & ~abits_val_;
@@ -1431,6 +1539,7 @@ vvp_vector4_t& vvp_vector4_t::operator &= (const vvp_vector4_t&that)
 	//  01 00 01 11 11
 	//  11 00 11 11 11
 	//  10 00 11 11 11
+      unshare_();
       if (size_ <= BITS_PER_WORD) {
 	    unsigned long tmp1 = abits_val_ | bbits_val_;
 	    unsigned long tmp2 = that.abits_val_ | that.bbits_val_;
@@ -1459,6 +1568,7 @@ vvp_vector4_t& vvp_vector4_t::operator |= (const vvp_vector4_t&that)
 	//  01 01 01 01 01
 	//  11 11 01 11 11
 	//  10 11 01 11 11
+      unshare_();
       if (size_ <= BITS_PER_WORD) {
 	    unsigned long tmp = abits_val_ | bbits_val_ |
 	                        that.abits_val_ | that.bbits_val_;
@@ -1976,22 +2086,18 @@ void vvp_vector2_t::copy_from_that_(const vvp_vector4_t&that)
       }
 
       vec_ = new unsigned long[words];
-      for (unsigned idx = 0 ;  idx < words ;  idx += 1)
-	    vec_[idx] = 0;
 
-      for (unsigned idx = 0 ;  idx < that.size() ;  idx += 1) {
-	    unsigned addr = idx / BITS_PER_WORD;
-	    unsigned shift = idx % BITS_PER_WORD;
+	/* Only the 1 bits (abit set and bbit clear) become 1s in the
+	   vector2, so the conversion can be done a word at a time. */
+      for (unsigned idx = 0 ;  idx < words ;  idx += 1) {
+	    unsigned adr = idx * BITS_PER_WORD;
+	    unsigned trans = that.size() - adr;
+	    if (trans > BITS_PER_WORD)
+		  trans = BITS_PER_WORD;
 
-	    switch (that.value(idx)) {
-		case BIT4_0:
-		case BIT4_X:
-		case BIT4_Z:
-		  break;
-		case BIT4_1:
-		  vec_[addr] |= 1UL << shift;
-		  break;
-	    }
+	    unsigned long abits, bbits;
+	    that.get_word(adr, trans, abits, bbits);
+	    vec_[idx] = abits & ~bbits;
       }
 }
 
@@ -2574,13 +2680,24 @@ vvp_vector4_t vector2_to_vector4(const vvp_vector2_t&that, unsigned wid)
 {
       vvp_vector4_t res (wid);
 
-      for (unsigned idx = 0 ;  idx < res.size() ;  idx += 1) {
-	    vvp_bit4_t bit = BIT4_0;
-
-	    if (that.value(idx))
-		  bit = BIT4_1;
+	/* Copy the vector2 a word at a time. Any bits of the result
+	   past the end of the vector2 are 0. */
+      const unsigned bits_per_word = 8 * sizeof(unsigned long);
+      const unsigned that_words = (that.wid_ + bits_per_word - 1) / bits_per_word;
+      for (unsigned idx = 0 ;  idx < res.size() ;  idx += bits_per_word) {
+	    unsigned trans = res.size() - idx;
+	    if (trans > bits_per_word)
+		  trans = bits_per_word;
+
+	    unsigned word = idx / bits_per_word;
+	    unsigned long val = 0;
+	    if (word < that_words) {
+		  val = that.vec_[word];
+		  if (idx + trans > that.wid_ && that.wid_ > idx)
+			val &= (1UL << (that.wid_ - idx)) - 1UL;
+	    }
 
-	    res.set_bit(idx, bit);
+	    res.set_word(idx, trans, val, 0);
       }
 
       return res;
@@ -2746,6 +2863,69 @@ vvp_vector8_t vvp_vector8_t::subvalue(unsigned base, unsigned wid) const
       return tmp;
 }
 
+bool vvp_vector8_t::is_hiz() const
+{
+	// HiZ is the all zero encoding of a vvp_scalar_t, so test the
+	// bytes a word at a time.
+      if (size_ <= sizeof val_)
+	    return ptr_ == 0;
+
+      unsigned idx = 0;
+      for ( ; idx+sizeof(unsigned long) <= size_ ; idx += sizeof(unsigned long)) {
+	    unsigned long word;
+	    memcpy(&word, ptr_+idx, sizeof word);
+	    if (word != 0)
+		  return false;
+      }
+
+      for ( ; idx < size_ ; idx += 1) {
+	    if (ptr_[idx] != 0)
+		  return false;
+      }
+
+      return true;
+}
+
+/*
+ * Resolve the two vectors bit by bit. Most bits of a resolved net
+ * are driven by only one of the drivers, or the drivers agree, and
+ * those bits can be resolved without looking at the strengths. So
+ * compare the encoded bytes a word at a time and only go through
+ * the scalar resolver for the words where both drivers are active
+ * and different.
+ */
+vvp_vector8_t resolve(const vvp_vector8_t&a, const vvp_vector8_t&b)
+{
+      assert(a.size() == b.size());
+      vvp_vector8_t out (a.size());
+
+      const unsigned size = out.size_;
+      const unsigned char*a_ptr = size <= sizeof a.val_? a.val_ : a.ptr_;
+      const unsigned char*b_ptr = size <= sizeof b.val_? b.val_ : b.ptr_;
+      unsigned char*out_ptr = size <= sizeof out.val_? out.val_ : out.ptr_;
+
+      unsigned idx = 0;
+      for ( ; idx+sizeof(unsigned long) <= size ; idx += sizeof(unsigned long)) {
+	    unsigned long a_word, b_word;
+	    memcpy(&a_word, a_ptr+idx, sizeof a_word);
+	    memcpy(&b_word, b_ptr+idx, sizeof b_word);
+
+	    if (a_word == b_word || b_word == 0) {
+		  memcpy(out_ptr+idx, &a_word, sizeof a_word);
+	    } else if (a_word == 0) {
+		  memcpy(out_ptr+idx, &b_word, sizeof b_word);
+	    } else {
+		  for (unsigned bdx = idx ; bdx < idx+sizeof(unsigned long) ; bdx += 1)
+			out.set_bit(bdx, resolve(a.value(bdx), b.value(bdx)));
+	    }
+      }
+
+      for ( ; idx < size ; idx += 1)
+	    out.set_bit(idx, resolve(a.value(idx), b.value(idx)));
+
+      return out;
+}
+
 void vvp_vector8_t::set_vec(unsigned base, const vvp_vector8_t&that)
 {
       assert((base+that.size()) <= size());
@@ -3282,27 +3462,40 @@ vvp_bit4_t compare_gtge(const vvp_vector4_t&lef, const vvp_vector4_t&rig,
       if (rig.has_xz())
 	    return BIT4_X;
 
-      for (unsigned idx = lef.size() ; idx > rig.size() ;  idx -= 1) {
-	    if (lef.value(idx-1) == BIT4_1)
+	// There are no X/Z bits, so the abits are the values and the
+	// compare can be done a word at a time, starting with the
+	// most significant words.
+      const unsigned word_bits = 8*sizeof(unsigned long);
+      unsigned long lv, rv, bb;
+
+      for (unsigned idx = rig.size() ; idx < lef.size() ;  idx += word_bits) {
+	    unsigned trans = lef.size() - idx;
+	    if (trans > word_bits)
+		  trans = word_bits;
+	    lef.get_word(idx, trans, lv, bb);
+	    if (lv != 0)
 		  return BIT4_1;
       }
 
-      for (unsigned idx = rig.size() ; idx > lef.size() ;  idx -= 1) {
-	    if (rig.value(idx-1) == BIT4_1)
+      for (unsigned idx = lef.size() ; idx < rig.size() ;  idx += word_bits) {
+	    unsigned trans = rig.size() - idx;
+	    if (trans > word_bits)
+		  trans = word_bits;
+	    rig.get_word(idx, trans, rv, bb);
+	    if (rv != 0)
 		  return BIT4_0;
       }
 
-      for (unsigned idx = min_size ; idx > 0 ;  idx -= 1) {
-	    vvp_bit4_t lv = lef.value(idx-1);
-	    vvp_bit4_t rv = rig.value(idx-1);
+      for (unsigned idx = min_size ; idx > 0 ;  ) {
+	    unsigned trans = idx < word_bits? idx : word_bits;
+	    idx -= trans;
+	    lef.get_word(idx, trans, lv, bb);
+	    rig.get_word(idx, trans, rv, bb);
 
 	    if (lv == rv)
 		  continue;
 
-	    if (lv == BIT4_1)
-		  return BIT4_1;
-	    else
-		  return BIT4_0;
+	    return lv > rv? BIT4_1 : BIT4_0;
       }
 
       return out_if_equal;
@@ -232,8 +232,25 @@ class vvp_vector4_t {
 	// array of longs, or a nil pointer if an XZ bit was detected
 	// in the array.
       unsigned long*subarray(unsigned idx, unsigned size) const;
+	// This does the same, but writes the bits into the val array
+	// supplied by the caller, and returns false if an XZ bit was
+	// detected.
+      bool subarray(unsigned long*val, unsigned idx, unsigned size) const;
       void setarray(unsigned idx, unsigned size, const unsigned long*val);
 
+	// Get/set up to one word of bits starting at the address as
+	// a pair of right justified abits/bbits words. These support
+	// word-at-a-time operations on parts of a vector.
+      void get_word(unsigned idx, unsigned size,
+		    unsigned long&abits, unsigned long&bbits) const;
+      void set_word(unsigned idx, unsigned size,
+		    unsigned long abits, unsigned long bbits);
+
+	// Read the abits/bbits words directly. These pointers are
+	// only good until the vector is next changed or destroyed.
+      const unsigned long*abits_words() const;
+      const unsigned long*bbits_words() const;
+
       void set_bit(unsigned idx, vvp_bit4_t val);
       void set_vec(unsigned idx, const vvp_vector4_t&that);
 
@@ -296,6 +313,17 @@ class vvp_vector4_t {
 
       void allocate_words_(unsigned long inita, unsigned long initb);
 
+	// Vectors wider than a word keep their bits in a heap array
+	// that is shared by copies of the vector, so that passing
+	// values around does not allocate. The reference count is
+	// kept in the word just before the abits, and methods that
+	// change the bits of a shared array call unshare_() first to
+	// get a private copy.
+      static unsigned long*allocate_bits_(unsigned cnt);
+      void release_bits_();
+      void unshare_();
+      void unshare_words_();
+
 	// Values in the vvp_vector4_t are stored split across two
 	// arrays. For each bit in the vector, there is an abit and a
 	// bbit. the encoding of a vvp_vector4_t is:
@@ -318,6 +346,16 @@ class vvp_vector4_t {
       };
 };
 
+inline const unsigned long* vvp_vector4_t::abits_words() const
+{
+      return size_ > BITS_PER_WORD? abits_ptr_ : &abits_val_;
+}
+
+inline const unsigned long* vvp_vector4_t::bbits_words() const
+{
+      return size_ > BITS_PER_WORD? bbits_ptr_ : &bbits_val_;
+}
+
 inline vvp_vector4_t::vvp_vector4_t(const vvp_vector4_t&that)
 {
       copy_from_(that);
@@ -349,23 +387,33 @@ inline vvp_vector4_t::vvp_vector4_t(unsigned size__, vvp_bit4_t val)
       allocate_words_(init_atable[val], init_btable[val]);
 }
 
-inline vvp_vector4_t::~vvp_vector4_t()
+inline void vvp_vector4_t::release_bits_()
 {
       if (size_ > BITS_PER_WORD) {
-	    delete[] abits_ptr_;
-	      // bbits_ptr_ actually points half-way into a
-	      // double-length array started at abits_ptr_
+	    if (--abits_ptr_[-1] == 0)
+		  delete[] (abits_ptr_-1);
+	      // bbits_ptr_ actually points half-way into the same
+	      // array, so there is nothing more to free.
       }
 }
 
+inline void vvp_vector4_t::unshare_()
+{
+      if (size_ > BITS_PER_WORD && abits_ptr_[-1] > 1)
+	    unshare_words_();
+}
+
+inline vvp_vector4_t::~vvp_vector4_t()
+{
+      release_bits_();
+}
+
 inline vvp_vector4_t& vvp_vector4_t::operator= (const vvp_vector4_t&that)
 {
       if (this == &that)
 	    return *this;
 
-      if (size_ > BITS_PER_WORD)
-	    delete[] abits_ptr_;
-
+      release_bits_();
       copy_from_(that);
 
       return *this;
@@ -412,6 +460,7 @@ inline vvp_vector4_t vvp_vector4_t::subvalue(unsigned adr, unsigned wid) const
 inline void vvp_vector4_t::set_bit(unsigned idx, vvp_bit4_t val)
 {
       assert(idx < size_);
+      unshare_();
 
       unsigned long off = idx % BITS_PER_WORD;
       unsigned long mask = 1UL << off;
@@ -612,6 +661,7 @@ class vvp_vector2_t {
       friend bool operator <  (const vvp_vector2_t&, const vvp_vector2_t&);
       friend bool operator <= (const vvp_vector2_t&, const vvp_vector2_t&);
       friend bool operator == (const vvp_vector2_t&, const vvp_vector2_t&);
+      friend vvp_vector4_t vector2_to_vector4(const vvp_vector2_t&, unsigned);
 
     public:
       vvp_vector2_t();
@@ -850,6 +900,7 @@ extern ostream& operator<< (ostream&, vvp_scalar_t);
 class vvp_vector8_t {
 
       friend vvp_vector8_t part_expand(const vvp_vector8_t&, unsigned, unsigned);
+      friend vvp_vector8_t resolve(const vvp_vector8_t&, const vvp_vector8_t&);
 
     public:
       explicit vvp_vector8_t(unsigned size =0);
@@ -877,6 +928,9 @@ class vvp_vector8_t {
 	// Test that the vectors are exactly equal
       bool eeq(const vvp_vector8_t&that) const;
 
+	// Return true if all the bits of the vector are HiZ.
+      bool is_hiz() const;
+
       vvp_vector8_t(const vvp_vector8_t&that);
       vvp_vector8_t& operator= (const vvp_vector8_t&that);
 
@@ -893,17 +947,7 @@ class vvp_vector8_t {
 
   /* Resolve uses the default Verilog resolver algorithm to resolve
      two drive vectors to a single output. */
-inline vvp_vector8_t resolve(const vvp_vector8_t&a, const vvp_vector8_t&b)
-{
-      assert(a.size() == b.size());
-      vvp_vector8_t out (a.size());
-
-      for (unsigned idx = 0 ;  idx < out.size() ;  idx += 1) {
-	    out.set_bit(idx, resolve(a.value(idx), b.value(idx)));
-      }
-
-      return out;
-}
+extern vvp_vector8_t resolve(const vvp_vector8_t&a, const vvp_vector8_t&b);
 
   /* This function implements the strength reduction implied by
      Verilog standard resistive devices. */
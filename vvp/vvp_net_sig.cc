@@ -97,6 +97,11 @@ double vvp_signal_value::real_value() const
       return 0;
 }
 
+const vvp_vector4_t* vvp_signal_value::vec4_value_ref() const
+{
+      return 0;
+}
+
 void vvp_net_t::force_vec4(const vvp_vector4_t&val, vvp_vector2_t mask)
 {
       assert(fil);
@@ -768,6 +773,18 @@ void vvp_wire_vec4::vec4_value(vvp_vector4_t&val) const
 	    val.set_bit(idx, filtered_value_(idx));
 }
 
+/*
+ * The driven value is the value of the wire unless some bits are
+ * forced, and then the value exists only as a filtered copy.
+ */
+const vvp_vector4_t* vvp_wire_vec4::vec4_value_ref() const
+{
+      if (test_force_mask_is_zero())
+	    return &bits4_;
+      else
+	    return 0;
+}
+
 vvp_wire_vec8::vvp_wire_vec8(unsigned wid)
 : bits8_(wid)
 {
@@ -102,6 +102,10 @@ class vvp_signal_value {
       virtual void vec4_value(vvp_vector4_t&) const =0;
       virtual double real_value() const;
 
+	// Return the vector that holds the current value, or nil if
+	// the value is not kept as a single vvp_vector4_t.
+      virtual const vvp_vector4_t* vec4_value_ref() const;
+
       virtual void get_signal_value(struct t_vpi_value*vp);
 };
 
@@ -303,6 +307,7 @@ class vvp_wire_vec4 : public vvp_wire_base {
       vvp_bit4_t value(unsigned idx) const;
       vvp_scalar_t scalar_value(unsigned idx) const;
       void vec4_value(vvp_vector4_t&) const;
+      const vvp_vector4_t* vec4_value_ref() const;
 
     private:
       vvp_bit4_t filtered_value_(unsigned idx) const;
@@ -48,6 +48,10 @@ class vvp_vpi_callback {
 	// vpi to get at the vvp value of the object.
       virtual void get_value(struct t_vpi_value*value) =0;
 
+	// This count goes up each time the value changes, so that
+	// readers can tell if a value changed since they last read it.
+      unsigned long change_count() const { return change_count_; }
+
     protected:
 	// Derived classes call this method to indicate that it is
 	// time to call the callback.
@@ -57,6 +61,7 @@ class vvp_vpi_callback {
       struct __vpiCallback*vpi_callbacks_;
       class __vpiArray* array_;
       unsigned long array_word_;
+      unsigned long change_count_;
 };
 
 